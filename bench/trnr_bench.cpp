@@ -0,0 +1,1107 @@
+/*
+ * trnr_bench.cpp
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures the cost of the block processing of every module and writes the results as
+// JSON. Every case is swept over sample rates, block sizes and channel counts:
+//
+//   trnr-bench [--filter module] [--rates 44100,48000,96000] [--blocks 64,256,1024]
+//              [--channels 1,2,8] [--seconds 0.25] [--repeats 3] [--no-ftz]
+//              [--out results.json]
+//
+// A case processes `seconds` of audio per repeat, in place and block by block, and the
+// fastest repeat is reported. The time includes copying the input into the block (well
+// below 0.1 ns per sample). Cycles are rdtsc reference cycles, null where rdtsc is not
+// available. Modules that are fixed to stereo only run with 2 channels.
+//
+// The nonlinear modules run naive, with adaa (_adaa) and inside the oversampler
+// (_os2, _os4, _os8, stereo only), pump and oneknob at several control rates.
+//
+//   trnr-bench --alias [--filter module] [--blocks 256]
+//
+// measures the aliasing of the nonlinear cases next to their cost instead: the alias
+// power of a full scale 2637 Hz sine at 48 kHz relative to its harmonics, in dB.
+//
+//   trnr-bench --control-rate [--filter module] [--blocks 256]
+//
+// measures pump and oneknob at every control rate against n = 1 on a sine in bursts:
+// the THD+N once the gain has settled and the largest gain deviation from n = 1, in dB.
+
+#include "../clip/adaa.h"
+#include "../clip/clip.h"
+#include "../clip/fold.h"
+#include "../clip/tube.h"
+#include "../companding/alaw.h"
+#include "../dynamics/limiter.h"
+#include "../dynamics/multiband.h"
+#include "../dynamics/oneknob.h"
+#include "../dynamics/pump.h"
+#include "../dynamics/window_detector.h"
+#include "../filter/chebyshev.h"
+#include "../filter/spliteq.h"
+#include "../filter/ysvf.h"
+#include "../oversampling/oversampler.h"
+#include "../synth/triplex.h"
+#include "../util/denormal.h"
+#include "../util/random.h"
+#include "../util/retro_buf.h"
+#include "../util/sample_format.h"
+#include "../util/smoother.h"
+#include "../util/waveshaper.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRNR_BENCH_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRNR_BENCH_RDTSC
+#endif
+
+using namespace trnr;
+
+struct bench_config {
+	double samplerate;
+	int block_size;
+	int channels;
+};
+
+// processes one block in place, owns the state of the module
+using bench_process = function<void(float** audio, int frames)>;
+
+// returns an empty function if the module does not support the configuration
+using bench_setup = function<bench_process(const bench_config& c)>;
+
+struct bench_case {
+	string module;
+	string variant;
+	bench_setup setup;
+	bool alias = false;	  // nonlinear, measured by --alias
+	int control_rate = 0; // gain computer every n samples, measured by --control-rate
+};
+
+struct bench_result {
+	const bench_case* bench;
+	bench_config config;
+	long frames;
+	double ns;
+	double cycles;
+};
+
+inline uint64_t bench_cycles()
+{
+#ifdef TRNR_BENCH_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// calls make with the channel count as a constant, for the channel templated modules
+template <typename t_make>
+inline bench_process bench_for_channels(int channels, t_make make)
+{
+	switch (channels) {
+	case 1:
+		return make(integral_constant<size_t, 1>());
+	case 2:
+		return make(integral_constant<size_t, 2>());
+	case 4:
+		return make(integral_constant<size_t, 4>());
+	case 8:
+		return make(integral_constant<size_t, 8>());
+	default:
+		return {};
+	}
+}
+
+// runs the module inside an oversampler, setup gets the oversampled configuration
+inline bench_process bench_oversampled(const bench_config& c, int ratio,
+										bench_setup setup)
+{
+	if (c.channels != 2) return {};
+
+	bench_process process = setup({c.samplerate * ratio, c.block_size * ratio, 2});
+	if (!process) return {};
+
+	auto os = make_shared<oversampler<float>>();
+	os->init(c.samplerate, ratio);
+	return [os, process, ratio](float** a, int f) {
+		float** up = os->upsample(a, f);
+		process(up, f * ratio);
+		os->downsample(a);
+	};
+}
+
+//////////
+// CLIP //
+//////////
+
+inline bench_process bench_clip(const bench_config& c)
+{
+	return bench_for_channels(c.channels, [&](auto n) -> bench_process {
+		auto s = make_shared<clip_n<decltype(n)::value>>();
+		clip_init(*s, c.samplerate);
+		return [s](float** a, int f) { clip_process_block(*s, a, a, f); };
+	});
+}
+
+// tube_amt sets the powerfactor, from 1 at full amount to 10 at none
+inline double bench_tube_amount(int powerfactor)
+{
+	return 1.0 - (powerfactor - 0.5) / 9.0;
+}
+
+inline bench_process bench_tube(const bench_config& c, int powerfactor, bool adaa)
+{
+	return bench_for_channels(c.channels, [&](auto n) -> bench_process {
+		auto s = make_shared<tube_n<decltype(n)::value>>();
+		tube_init(*s, c.samplerate);
+		s->set_tube(bench_tube_amount(powerfactor));
+		s->adaa = adaa;
+		return [s](float** a, int f) { tube_process_block(*s, a, a, f); };
+	});
+}
+
+// stateless hard clip of the input times drive
+inline bench_process bench_hard_clip(const bench_config& c, float drive, bool adaa)
+{
+	auto states = make_shared<vector<adaa_state>>(c.channels);
+	return [states, drive, adaa](float** a, int f) {
+		for (size_t ch = 0; ch < states->size(); ++ch) {
+			float* audio = a[ch];
+			for (int i = 0; i < f; ++i) audio[i] *= drive;
+			if (adaa) adaa_hard_clip_block((*states)[ch], audio, f);
+			else {
+				for (int i = 0; i < f; ++i) audio[i] = adaa_hard_clip_curve(audio[i]);
+			}
+		}
+	};
+}
+
+// the input times drive, so the bench signal reaches the folds
+inline bench_process bench_fold(const bench_config& c, bool bipolar, float drive,
+								bool adaa)
+{
+	auto states = make_shared<vector<adaa_state>>(c.channels);
+	return [states, bipolar, drive, adaa](float** a, int f) {
+		for (size_t ch = 0; ch < states->size(); ++ch) {
+			float* audio = a[ch];
+			for (int i = 0; i < f; ++i) audio[i] *= drive;
+			if (adaa && bipolar) adaa_fold_bipolar_block((*states)[ch], audio, f);
+			else if (adaa) adaa_fold_block((*states)[ch], audio, f);
+			else if (bipolar) fold_bipolar_block(audio, f);
+			else fold_block(audio, f);
+		}
+	};
+}
+
+inline bench_process bench_waveshaper(const bench_config& c)
+{
+	auto w = make_shared<waveshaper>();
+	waveshaper_build(*w, [](double x) { return tanh(x); }, -4.f, 4.f);
+	int channels = c.channels;
+	return [w, channels](float** a, int f) {
+		for (int ch = 0; ch < channels; ++ch) waveshaper_process_block(*w, a[ch], f);
+	};
+}
+
+inline bench_process bench_alaw(const bench_config& c)
+{
+	int channels = c.channels;
+	return [channels](float** a, int f) {
+		for (int ch = 0; ch < channels; ++ch) {
+			alaw_encode_block(a[ch], f);
+			alaw_decode_block(a[ch], f);
+		}
+	};
+}
+
+inline bench_process bench_mulaw(const bench_config& c)
+{
+	int channels = c.channels;
+	return [channels](float** a, int f) {
+		for (int ch = 0; ch < channels; ++ch) {
+			mulaw_encode_block(a[ch], f);
+			mulaw_decode_block(a[ch], f);
+		}
+	};
+}
+
+////////////
+// FILTER //
+////////////
+
+inline bench_process bench_ysvf(const bench_config& c, ysvf_types type)
+{
+	if (c.channels != 2) return {};
+
+	auto y = make_shared<ysvf>();
+	ysvf_init(*y, c.samplerate);
+	y->filter_type = type;
+	ysvf_set_param(*y, Y_FREQUENCY, 0.5f);
+	ysvf_set_param(*y, Y_RESONANCE, 0.5f);
+	return [y](float** a, int f) { ysvf_process_samples(*y, a, a, f); };
+}
+
+inline void bench_spliteq_init(spliteq& eq, double samplerate, spliteq_mode mode,
+							   double bass_gain, double mid_gain, double treble_gain)
+{
+	spliteq_init(eq, samplerate, 150.0, 1700.0);
+	spliteq_update(eq, 0.0, 1.0, 150.0, 1700.0, bass_gain, mid_gain, treble_gain);
+	// skips the transition ramp
+	eq.current_mode = eq.target_mode = mode;
+}
+
+inline bench_process bench_spliteq(const bench_config& c, spliteq_mode mode)
+{
+	if (c.channels != 2) return {};
+
+	auto eq = make_shared<spliteq>();
+	bench_spliteq_init(*eq, c.samplerate, mode, 3.0, -2.0, 4.0);
+	return [eq](float** a, int f) { spliteq_process_block(*eq, a, f); };
+}
+
+inline bench_process bench_chebyshev(const bench_config& c)
+{
+	auto filters = make_shared<vector<chebyshev>>(c.channels);
+	for (chebyshev& filter : *filters) filter.reset(c.samplerate, 8000.0);
+	return [filters](float** a, int f) {
+		for (size_t ch = 0; ch < filters->size(); ++ch)
+			(*filters)[ch].process_block(a[ch], f);
+	};
+}
+
+// the oversampler alone
+inline bench_process bench_oversampler(const bench_config& c, int ratio)
+{
+	return bench_oversampled(c, ratio, [](const bench_config&) -> bench_process {
+		return [](float**, int) {};
+	});
+}
+
+//////////////
+// DYNAMICS //
+//////////////
+
+inline bench_process bench_pump(const bench_config& c, int control_rate)
+{
+	return bench_for_channels(c.channels, [&](auto n) -> bench_process {
+		auto p = make_shared<pump_n<decltype(n)::value>>();
+		pump_init(*p, c.samplerate);
+		pump_set_param(*p, PUMP_THRESHOLD, -20.f);
+		pump_set_param(*p, PUMP_RATIO, 4.f);
+		pump_set_control_rate(*p, control_rate);
+		return [p](float** a, int f) { pump_process_block(*p, a, a, f); };
+	});
+}
+
+inline bench_process bench_oneknob(const bench_config& c, int control_rate)
+{
+	return bench_for_channels(c.channels, [&](auto n) -> bench_process {
+		auto o = make_shared<oneknob_comp_n<decltype(n)::value>>();
+		oneknob_init(*o, c.samplerate, 10.f);
+		o->amount = 0.5f;
+		oneknob_set_control_rate(*o, control_rate);
+		return [o](float** a, int f) { oneknob_process_block(*o, a, f); };
+	});
+}
+
+inline bench_process bench_limiter(const bench_config& c)
+{
+	return bench_for_channels(c.channels, [&](auto n) -> bench_process {
+		auto l = make_shared<limiter_n<decltype(n)::value>>();
+		limiter_init(*l, c.samplerate);
+		limiter_set_param(*l, LIMITER_CEILING, -6.f);
+		return [l](float** a, int f) { limiter_process_block(*l, a, f); };
+	});
+}
+
+inline bench_process bench_multiband(const bench_config& c)
+{
+	return bench_for_channels(c.channels, [&](auto n) -> bench_process {
+		auto mb = make_shared<multiband_n<decltype(n)::value>>();
+		multiband_init(*mb, c.samplerate);
+		for (int b = 0; b < MULTIBAND_BANDS; ++b) {
+			mb->bands[b].threshold_db = -20.f;
+			multiband_update_band(*mb, (multiband_band_index)b);
+		}
+		return [mb](float** a, int f) { multiband_process_block(*mb, a, f); };
+	});
+}
+
+// what multiband replaces: one spliteq per band isolating it, one pump per band, a sum
+struct multiband_chain {
+	spliteq eq[MULTIBAND_BANDS];
+	pump comp[MULTIBAND_BANDS];
+	vector<float> band[MULTIBAND_BANDS][2];
+};
+
+inline bench_process bench_multiband_chain(const bench_config& c)
+{
+	if (c.channels != 2) return {};
+
+	auto s = make_shared<multiband_chain>();
+	for (int b = 0; b < MULTIBAND_BANDS; ++b) {
+		double gains[MULTIBAND_BANDS] = {-120.0, -120.0, -120.0};
+		gains[b] = 0.0;
+		bench_spliteq_init(s->eq[b], c.samplerate, LINKWITZ_RILEY, gains[MULTIBAND_LOW],
+						   gains[MULTIBAND_MID], gains[MULTIBAND_HIGH]);
+		pump_init(s->comp[b], c.samplerate);
+		pump_set_param(s->comp[b], PUMP_THRESHOLD, -20.f);
+		pump_set_param(s->comp[b], PUMP_RATIO, 4.f);
+		for (vector<float>& ch : s->band[b]) ch.resize(c.block_size);
+	}
+
+	return [s](float** a, int f) {
+		for (int b = 0; b < MULTIBAND_BANDS; ++b) {
+			float* band[2] = {s->band[b][0].data(), s->band[b][1].data()};
+			for (int ch = 0; ch < 2; ++ch) memcpy(band[ch], a[ch], f * sizeof(float));
+			spliteq_process_block(s->eq[b], band, f);
+			pump_process_block(s->comp[b], band, band, f);
+		}
+		for (int ch = 0; ch < 2; ++ch) {
+			for (int i = 0; i < f; ++i)
+				a[ch][i] = s->band[0][ch][i] + s->band[1][ch][i] + s->band[2][ch][i];
+		}
+	};
+}
+
+inline bench_process bench_window_rms(const bench_config& c)
+{
+	auto d = make_shared<window_rms>();
+	window_rms_init(*d, c.channels, c.samplerate, 10.f);
+	return [d](float** a, int f) { window_rms_process_block(*d, a, f); };
+}
+
+inline bench_process bench_window_peak(const bench_config& c)
+{
+	auto d = make_shared<window_peak>();
+	window_peak_init(*d, c.channels, c.samplerate, 10.f);
+	return [d](float** a, int f) { window_peak_process_block(*d, a, f); };
+}
+
+///////////
+// SYNTH //
+///////////
+
+// chords of voices notes, a new one every 100 ms at sample accurate offsets
+struct tx_synth_sequence {
+	tx_synth synth;
+	vector<midi_event> events;
+	int voices;
+	long period;
+	long position = 0;
+	int root = -1;
+};
+
+inline void bench_tx_synth_events(tx_synth_sequence& s, int frames)
+{
+	s.events.clear();
+
+	long next = (s.position + s.period - 1) / s.period * s.period;
+	for (; next < s.position + frames; next += s.period) {
+		int offset = (int)(next - s.position);
+		midi_event ev;
+		for (int i = 0; i < s.voices && s.root >= 0; ++i) {
+			make_note_off(ev, s.root + i * 3, 0.f, offset);
+			s.events.push_back(ev);
+		}
+		s.root = s.root < 0 ? 48 : 48 + (s.root - 48 + 5) % 12;
+		for (int i = 0; i < s.voices; ++i) {
+			make_note_on(ev, s.root + i * 3, 1.f, offset);
+			s.events.push_back(ev);
+		}
+	}
+	s.position += frames;
+}
+
+inline bench_process bench_tx_synth(const bench_config& c, int voices)
+{
+	if (c.channels != 2) return {};
+
+	auto s = make_shared<tx_synth_sequence>();
+	tx_synth_init(s->synth, c.samplerate);
+	s->synth.allocator.active_voice_count = voices;
+	for (tx_state& v : s->synth.voices) {
+		// the random start phases would make every render different
+		v.feedback_osc.phase_reset = true;
+		for (tx_operator* op : {&v.op1, &v.op2, &v.op3}) {
+			op->oscillator.phase_reset = true;
+			op->envelope.sustain_level = 1.f;
+		}
+	}
+	s->voices = voices;
+	s->period = (long)(0.1 * c.samplerate);
+	s->events.reserve(4 * voices);
+
+	return [s](float** a, int f) {
+		bench_tx_synth_events(*s, f);
+		tx_synth_process_block(s->synth, a, f, s->events);
+	};
+}
+
+//////////
+// UTIL //
+//////////
+
+inline bench_process bench_retro_buf(const bench_config& c)
+{
+	if (c.channels != 2) return {};
+
+	class sine_buf : public retro_buf {
+	public:
+		vector<float> data;
+		float get_sample(size_t index, size_t /*channel*/) override
+		{
+			return data[index];
+		}
+	};
+
+	auto r = make_shared<sine_buf>();
+	r->data.resize((size_t)c.samplerate);
+	for (size_t i = 0; i < r->data.size(); ++i)
+		r->data[i] = 0.5f * sinf(2.f * (float)M_PI * 220.f * i / (float)c.samplerate);
+	r->set_host_samplerate(c.samplerate);
+	r->set_buf_samplerate(c.samplerate);
+	r->set_buffer_size(r->data.size());
+	r->set_channel_count(2);
+
+	auto out = make_shared<vector<double>>(2 * c.block_size);
+	return [r, out](float** a, int f) {
+		retro_buf_modulation mod {};
+		mod.midi_note = 60.0;
+		mod.samplerate = 22050.0;
+		mod.bitrate = 8.0;
+		mod.end = r->data.size() - 1;
+		mod.looping = true;
+		mod.jitter = 2;
+
+		double* outputs[2] = {out->data(), out->data() + f};
+		r->process_block(outputs, f, mod);
+		for (int ch = 0; ch < 2; ++ch)
+			for (int i = 0; i < f; ++i) a[ch][i] = (float)outputs[ch][i];
+	};
+}
+
+inline bench_process bench_smoother(const bench_config& c)
+{
+	auto s = make_shared<vector<smoother>>(c.channels);
+	for (smoother& sm : *s) smoother_init(sm, c.samplerate, 20.f);
+	auto flip = make_shared<bool>(false);
+
+	// a new target every block keeps the ramps running
+	return [s, flip](float** a, int f) {
+		*flip = !*flip;
+		for (size_t ch = 0; ch < s->size(); ++ch) {
+			smoother_set_target((*s)[ch], *flip ? 1.f : 0.f);
+			smoother_process_block((*s)[ch], a[ch], f);
+		}
+	};
+}
+
+// planar to interleaved and back, the way a host callback converts
+inline bench_process bench_sample_format(const bench_config& c, sample_format format)
+{
+	auto interleaved =
+		make_shared<vector<unsigned char>>(sample_format_bytes(format) * c.channels *
+										   c.block_size);
+	auto dither = make_shared<prng>();
+	prng_init(*dither, 1);
+	size_t channels = c.channels;
+
+	return [interleaved, dither, channels, format](float** a, int f) {
+		interleave(a, interleaved->data(), format, channels, f, dither.get());
+		deinterleave(interleaved->data(), format, a, channels, f);
+	};
+}
+
+inline vector<bench_case> bench_cases()
+{
+	vector<bench_case> cases;
+
+	cases.push_back({"clip", "default", bench_clip});
+	for (int pf : {1, 5, 10}) {
+		string name = "powerfactor_" + to_string(pf);
+		cases.push_back({"tube", name,
+						 [pf](const bench_config& c) { return bench_tube(c, pf, false); },
+						 true});
+		cases.push_back({"tube", name + "_adaa",
+						 [pf](const bench_config& c) { return bench_tube(c, pf, true); },
+						 true});
+	}
+
+	// the anti-aliasing alternatives to adaa
+	auto oversampled = [&cases](const string& module, const string& variant,
+								bench_setup setup) {
+		for (int ratio : {2, 4, 8}) {
+			cases.push_back({module, variant + "_os" + to_string(ratio),
+							 [ratio, setup](const bench_config& c) {
+								 return bench_oversampled(c, ratio, setup);
+							 },
+							 true});
+		}
+	};
+	oversampled("tube", "powerfactor_5", [](const bench_config& c) {
+		return bench_tube(c, 5, false);
+	});
+
+	for (bool adaa : {false, true}) {
+		string suffix = adaa ? "_adaa" : "";
+		cases.push_back({"hard_clip", "x4" + suffix,
+						 [adaa](const bench_config& c) {
+							 return bench_hard_clip(c, 4.f, adaa);
+						 },
+						 true});
+		cases.push_back({"fold", "closed_x3" + suffix,
+						 [adaa](const bench_config& c) {
+							 return bench_fold(c, false, 3.f, adaa);
+						 },
+						 true});
+		cases.push_back({"fold", "bipolar_x5" + suffix,
+						 [adaa](const bench_config& c) {
+							 return bench_fold(c, true, 5.f, adaa);
+						 },
+						 true});
+	}
+	oversampled("hard_clip", "x4", [](const bench_config& c) {
+		return bench_hard_clip(c, 4.f, false);
+	});
+	oversampled("fold", "closed_x3", [](const bench_config& c) {
+		return bench_fold(c, false, 3.f, false);
+	});
+	oversampled("fold", "bipolar_x5", [](const bench_config& c) {
+		return bench_fold(c, true, 5.f, false);
+	});
+	cases.push_back({"waveshaper", "tanh", bench_waveshaper});
+	cases.push_back({"alaw", "roundtrip", bench_alaw});
+	cases.push_back({"mulaw", "roundtrip", bench_mulaw});
+
+	const char* types[] = {"lowpass", "highpass", "bandpass", "notch"};
+	for (int t = Y_LOWPASS; t <= Y_NOTCH; ++t) {
+		cases.push_back({"ysvf", types[t], [t](const bench_config& c) {
+							 return bench_ysvf(c, (ysvf_types)t);
+						 }});
+	}
+	cases.push_back({"spliteq", "cascade_sum", [](const bench_config& c) {
+						 return bench_spliteq(c, CASCADE_SUM);
+					 }});
+	cases.push_back({"spliteq", "linkwitz_riley", [](const bench_config& c) {
+						 return bench_spliteq(c, LINKWITZ_RILEY);
+					 }});
+	cases.push_back({"chebyshev", "lowpass", bench_chebyshev});
+	for (int ratio : {1, 2, 4, 8}) {
+		cases.push_back({"oversampler", "ratio_" + to_string(ratio),
+						 [ratio](const bench_config& c) {
+							 return bench_oversampler(c, ratio);
+						 }});
+	}
+
+	// the gain computer every n samples
+	for (int n : {1, 4, 8, 16, 32}) {
+		string name = "control_rate_" + to_string(n);
+		cases.push_back({"pump", name,
+						 [n](const bench_config& c) { return bench_pump(c, n); }, false,
+						 n});
+		cases.push_back({"oneknob", name,
+						 [n](const bench_config& c) { return bench_oneknob(c, n); },
+						 false, n});
+	}
+	cases.push_back({"limiter", "default", bench_limiter});
+	cases.push_back({"multiband", "default", bench_multiband});
+	cases.push_back({"multiband", "spliteq_pump_chain", bench_multiband_chain});
+	cases.push_back({"window_rms", "10ms", bench_window_rms});
+	cases.push_back({"window_peak", "10ms", bench_window_peak});
+
+	for (int voices : {1, 4, 8, 16}) {
+		cases.push_back({"tx_synth", "voices_" + to_string(voices),
+						 [voices](const bench_config& c) {
+							 return bench_tx_synth(c, voices);
+						 }});
+	}
+
+	cases.push_back({"retro_buf", "default", bench_retro_buf});
+	cases.push_back({"smoother", "ramp", bench_smoother});
+	cases.push_back({"sample_format", "int16", [](const bench_config& c) {
+						 return bench_sample_format(c, SAMPLE_INT16);
+					 }});
+	cases.push_back({"sample_format", "float32", [](const bench_config& c) {
+						 return bench_sample_format(c, SAMPLE_FLOAT32);
+					 }});
+	return cases;
+}
+
+////////////
+// RUNNER //
+////////////
+
+struct bench_options {
+	string filter;
+	vector<double> samplerates = {44100.0, 48000.0, 96000.0};
+	vector<double> block_sizes = {64, 256, 1024};
+	vector<double> channels = {1, 2, 8};
+	double seconds = 0.25;
+	int repeats = 3;
+	bool ftz = true;
+	const char* out = nullptr;
+	bool alias = false;
+	bool control_rate = false;
+};
+
+// one second of a sine per channel plus noise, gated every quarter second so the
+// dynamics modules keep moving
+inline vector<vector<float>> bench_signal(const bench_config& c)
+{
+	prng random;
+	prng_init(random, 1);
+
+	size_t frames = (size_t)c.samplerate;
+	vector<vector<float>> signal(c.channels, vector<float>(frames));
+	for (int ch = 0; ch < c.channels; ++ch) {
+		double increment = 2.0 * M_PI * 110.0 * (ch + 1) / c.samplerate;
+		for (size_t i = 0; i < frames; ++i) {
+			float level = (i * 4 / frames) % 2 ? 0.25f : 1.f;
+			float x = 0.5f * (float)sin(increment * i) + 0.1f * prng_bipolar(random);
+			signal[ch][i] = level * x;
+		}
+	}
+	return signal;
+}
+
+inline bench_result bench_run(const bench_case& b, const bench_config& c,
+							  bench_process& process, const bench_options& o)
+{
+	vector<vector<float>> input = bench_signal(c);
+	vector<vector<float>> work(c.channels, vector<float>(c.block_size));
+	vector<float*> audio(c.channels);
+	for (int ch = 0; ch < c.channels; ++ch) audio[ch] = work[ch].data();
+
+	size_t position = 0;
+	auto render = [&](long blocks) {
+		for (long i = 0; i < blocks; ++i) {
+			if (position + c.block_size > input[0].size()) position = 0;
+			for (int ch = 0; ch < c.channels; ++ch)
+				memcpy(audio[ch], &input[ch][position], c.block_size * sizeof(float));
+			process(audio.data(), c.block_size);
+			position += c.block_size;
+		}
+	};
+
+	long blocks = max(1L, (long)(o.seconds * c.samplerate / c.block_size));
+	bench_result result {&b, c, blocks * c.block_size, 0.0, 0.0};
+
+	// first blocks allocate and warm the caches
+	render(max(1L, blocks / 4));
+
+	for (int r = 0; r < o.repeats; ++r) {
+		auto start = chrono::steady_clock::now();
+		uint64_t start_cycles = bench_cycles();
+		render(blocks);
+		uint64_t cycles = bench_cycles() - start_cycles;
+		chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+		double ns = elapsed.count();
+
+		if (r == 0 || ns < result.ns) {
+			result.ns = ns;
+			result.cycles = (double)cycles;
+		}
+	}
+	return result;
+}
+
+inline void bench_write_json(FILE* file, const vector<bench_result>& results,
+							 const bench_options& o)
+{
+#ifdef TRNR_WAVESHAPER_SSE2
+	const char* simd = "sse2";
+#else
+	const char* simd = "none";
+#endif
+#ifdef TRNR_BENCH_RDTSC
+	const bool rdtsc = true;
+#else
+	const bool rdtsc = false;
+#endif
+
+	fprintf(file, "{\n  \"simd\": \"%s\",\n  \"ftz\": %s,\n  \"rdtsc\": %s,\n", simd,
+			o.ftz ? "true" : "false", rdtsc ? "true" : "false");
+	fprintf(file, "  \"results\": [");
+
+	for (size_t i = 0; i < results.size(); ++i) {
+		const bench_result& r = results[i];
+		double samples = (double)r.frames * r.config.channels;
+
+		fprintf(file, "%s\n    {\"module\": \"%s\", \"variant\": \"%s\", ", i ? "," : "",
+				r.bench->module.c_str(), r.bench->variant.c_str());
+		fprintf(file, "\"samplerate\": %.0f, \"block_size\": %d, \"channels\": %d, ",
+				r.config.samplerate, r.config.block_size, r.config.channels);
+		fprintf(file, "\"frames\": %ld, ", r.frames);
+		fprintf(file, "\"ns_per_frame\": %.4f, \"ns_per_sample\": %.4f, ",
+				r.ns / r.frames, r.ns / samples);
+		if (rdtsc) fprintf(file, "\"cycles_per_sample\": %.4f}", r.cycles / samples);
+		else fprintf(file, "\"cycles_per_sample\": null}");
+	}
+	fprintf(file, "\n  ]\n}\n");
+}
+
+inline vector<double> bench_parse_list(const char* list)
+{
+	vector<double> values;
+	for (char* end; *list; list = *end ? end + 1 : end) {
+		values.push_back(strtod(list, &end));
+		if (end == list) break;
+	}
+	return values;
+}
+
+inline bool bench_parse_options(bench_options& o, int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (arg == "--no-ftz") {
+			o.ftz = false;
+			continue;
+		}
+		if (arg == "--alias") {
+			o.alias = true;
+			continue;
+		}
+		if (arg == "--control-rate") {
+			o.control_rate = true;
+			continue;
+		}
+		if (!value) return false;
+		if (arg == "--filter") o.filter = value;
+		else if (arg == "--rates") o.samplerates = bench_parse_list(value);
+		else if (arg == "--blocks") o.block_sizes = bench_parse_list(value);
+		else if (arg == "--channels") o.channels = bench_parse_list(value);
+		else if (arg == "--seconds") o.seconds = atof(value);
+		else if (arg == "--repeats") o.repeats = max(1, atoi(value));
+		else if (arg == "--out") o.out = value;
+		else return false;
+		i++;
+	}
+	return true;
+}
+
+///////////
+// ALIAS //
+///////////
+
+// The sine sits on bin BENCH_ALIAS_BIN of a BENCH_ALIAS_FRAMES long DFT (2637 Hz at
+// 48 kHz), so the harmonics and the aliases folded back from above nyquist land on exact
+// bins and a rectangular window has no leakage.
+constexpr double BENCH_ALIAS_SAMPLERATE = 48000.0;
+constexpr int BENCH_ALIAS_FRAMES = 65536;
+constexpr int BENCH_ALIAS_BIN = 3600;
+
+// power of bin k of a real signal, one sided and normalized like the mean square
+inline double bench_bin_power(const vector<float>& x, int k)
+{
+	// goertzel
+	const double coefficient = 2.0 * cos(2.0 * M_PI * k / x.size());
+	double s1 = 0.0, s2 = 0.0;
+	for (float sample : x) {
+		double s0 = sample + coefficient * s1 - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+	double power = s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+	return 2.0 * power / ((double)x.size() * x.size());
+}
+
+// Alias power relative to the power of the harmonics below nyquist, in dB. A full scale
+// sine goes through the case (which sets its own drive) for one settling period and
+// one measured period.
+inline double bench_alias_db(const bench_case& b, int block_size)
+{
+	bench_config c {BENCH_ALIAS_SAMPLERATE, block_size, 2};
+	bench_process process = b.setup(c);
+	if (!process) return NAN;
+
+	const int frames = BENCH_ALIAS_FRAMES;
+	vector<float> out[2] = {vector<float>(frames), vector<float>(frames)};
+	for (int period = 0; period < 2; ++period) {
+		for (int ch = 0; ch < 2; ++ch) {
+			for (int i = 0; i < frames; ++i)
+				out[ch][i] = (float)sin(2.0 * M_PI * BENCH_ALIAS_BIN * i / frames);
+		}
+		for (int start = 0; start < frames; start += block_size) {
+			int n = min(block_size, frames - start);
+			float* audio[2] = {&out[0][start], &out[1][start]};
+			process(audio, n);
+		}
+	}
+
+	const vector<float>& x = out[0];
+	double mean = 0.0, square = 0.0;
+	for (float sample : x) {
+		mean += sample;
+		square += (double)sample * sample;
+	}
+	mean /= frames;
+	double total = square / frames - mean * mean;
+
+	double harmonics = 0.0;
+	for (int k = BENCH_ALIAS_BIN; k < frames / 2; k += BENCH_ALIAS_BIN)
+		harmonics += bench_bin_power(x, k);
+
+	return 10.0 * log10(max(total - harmonics, 1e-30) / harmonics);
+}
+
+// alias level and cost of the nonlinear cases at 48 kHz, stereo, returns the exit code
+inline int bench_alias(const vector<bench_case>& cases, const bench_options& o)
+{
+	FILE* file = o.out ? fopen(o.out, "w") : stdout;
+	if (!file) {
+		fprintf(stderr, "trnr-bench: cannot write %s\n", o.out);
+		return 1;
+	}
+
+	int block_size = o.block_sizes.empty() ? 256 : (int)o.block_sizes[0];
+	if (block_size < 1) block_size = 256;
+	fprintf(file, "{\n  \"samplerate\": %.0f,\n  \"block_size\": %d,\n",
+			BENCH_ALIAS_SAMPLERATE, block_size);
+	fprintf(file, "  \"frequency\": %.2f,\n  \"alias\": [",
+			BENCH_ALIAS_BIN * BENCH_ALIAS_SAMPLERATE / BENCH_ALIAS_FRAMES);
+
+	int written = 0;
+	for (const bench_case& b : cases) {
+		if (!b.alias) continue;
+		if (!o.filter.empty() && b.module.find(o.filter) == string::npos) continue;
+
+		bench_config c {BENCH_ALIAS_SAMPLERATE, block_size, 2};
+		bench_process process = b.setup(c);
+		if (!process) continue;
+		bench_result r = bench_run(b, c, process, o);
+		double alias_db = bench_alias_db(b, block_size);
+
+		fprintf(stderr, "%-14s %-20s %7.1f dB alias %9.3f ns/frame\n", b.module.c_str(),
+				b.variant.c_str(), alias_db, r.ns / r.frames);
+		fprintf(file, "%s\n    {\"module\": \"%s\", \"variant\": \"%s\", ",
+				written++ ? "," : "", b.module.c_str(), b.variant.c_str());
+		fprintf(file, "\"alias_db\": %.2f, \"ns_per_frame\": %.4f}", alias_db,
+				r.ns / r.frames);
+	}
+	fprintf(file, "\n  ]\n}\n");
+	if (o.out) fclose(file);
+	return 0;
+}
+
+//////////////////
+// CONTROL RATE //
+//////////////////
+
+// The alias sine in BENCH_BURST_COUNT bursts of BENCH_BURST_FRAMES that alternate between
+// -20 and 0 dBFS, then held at 0 dBFS for one DFT length. The held part starts on a
+// multiple of the DFT length, so the fundamental stays on an exact bin.
+constexpr int BENCH_BURST_FRAMES = 8192;
+constexpr int BENCH_BURST_COUNT = 8;
+constexpr int BENCH_BURST_HELD = BENCH_BURST_FRAMES * BENCH_BURST_COUNT;
+
+inline float bench_burst_level(int i)
+{
+	if (i >= BENCH_BURST_HELD) return 1.f;
+	return (i / BENCH_BURST_FRAMES) % 2 ? 1.f : 0.1f;
+}
+
+inline float bench_burst(int i)
+{
+	double phase = 2.0 * M_PI * BENCH_ALIAS_BIN * (i % BENCH_ALIAS_FRAMES);
+	return bench_burst_level(i) * (float)sin(phase / BENCH_ALIAS_FRAMES);
+}
+
+// the left channel of the bursts through the case at 48 kHz, stereo
+inline vector<float> bench_burst_render(const bench_case& b, int block_size)
+{
+	bench_config c {BENCH_ALIAS_SAMPLERATE, block_size, 2};
+	bench_process process = b.setup(c);
+	if (!process) return {};
+
+	const int frames = BENCH_BURST_HELD + BENCH_ALIAS_FRAMES;
+	vector<float> out[2] = {vector<float>(frames), vector<float>(frames)};
+	for (int ch = 0; ch < 2; ++ch)
+		for (int i = 0; i < frames; ++i) out[ch][i] = bench_burst(i);
+
+	for (int start = 0; start < frames; start += block_size) {
+		int n = min(block_size, frames - start);
+		float* audio[2] = {&out[0][start], &out[1][start]};
+		process(audio, n);
+	}
+	return out[0];
+}
+
+// power of everything but the fundamental relative to it over the held part, in dB
+inline double bench_thd_n_db(const vector<float>& x)
+{
+	vector<float> held(x.begin() + BENCH_BURST_HELD, x.end());
+	double square = 0.0;
+	for (float sample : held) square += (double)sample * sample;
+	double total = square / held.size();
+
+	double fundamental = bench_bin_power(held, BENCH_ALIAS_BIN);
+	return 10.0 * log10(max(total - fundamental, 1e-30) / fundamental);
+}
+
+// Largest gain difference to the reference over the bursts, in dB. Only samples where
+// the input is above half the burst level count, so zero crossings do not.
+inline double bench_gain_deviation_db(const vector<float>& x,
+									  const vector<float>& reference)
+{
+	double deviation = 0.0;
+	for (int i = 0; i < BENCH_BURST_HELD; ++i) {
+		if (fabs(bench_burst(i)) < 0.5f * bench_burst_level(i)) continue;
+		double ratio = fabs(x[i]) / max(fabs((double)reference[i]), 1e-30);
+		deviation = max(deviation, fabs(20.0 * log10(max(ratio, 1e-30))));
+	}
+	return deviation;
+}
+
+// THD+N, gain deviation from n = 1 and cost of every control rate at 48 kHz, stereo,
+// returns the exit code
+inline int bench_control_rate(const vector<bench_case>& cases, const bench_options& o)
+{
+	FILE* file = o.out ? fopen(o.out, "w") : stdout;
+	if (!file) {
+		fprintf(stderr, "trnr-bench: cannot write %s\n", o.out);
+		return 1;
+	}
+
+	int block_size = o.block_sizes.empty() ? 256 : (int)o.block_sizes[0];
+	if (block_size < 1) block_size = 256;
+	fprintf(file, "{\n  \"samplerate\": %.0f,\n  \"block_size\": %d,\n",
+			BENCH_ALIAS_SAMPLERATE, block_size);
+	fprintf(file, "  \"frequency\": %.2f,\n  \"control_rate\": [",
+			BENCH_ALIAS_BIN * BENCH_ALIAS_SAMPLERATE / BENCH_ALIAS_FRAMES);
+
+	int written = 0;
+	for (const bench_case& b : cases) {
+		if (!b.control_rate) continue;
+		if (!o.filter.empty() && b.module.find(o.filter) == string::npos) continue;
+
+		const bench_case* reference = nullptr;
+		for (const bench_case& r : cases)
+			if (r.module == b.module && r.control_rate == 1) reference = &r;
+		if (!reference) continue;
+
+		bench_config c {BENCH_ALIAS_SAMPLERATE, block_size, 2};
+		bench_process process = b.setup(c);
+		if (!process) continue;
+		bench_result r = bench_run(b, c, process, o);
+		double ns = r.ns / ((double)r.frames * c.channels);
+
+		vector<float> x = bench_burst_render(b, block_size);
+		double thd_n_db = bench_thd_n_db(x);
+		double deviation_db =
+			bench_gain_deviation_db(x, bench_burst_render(*reference, block_size));
+
+		fprintf(stderr, "%-14s %-20s %7.1f dB thd+n %6.3f dB deviation %9.3f ns/sample\n",
+				b.module.c_str(), b.variant.c_str(), thd_n_db, deviation_db, ns);
+		fprintf(file, "%s\n    {\"module\": \"%s\", \"variant\": \"%s\", ",
+				written++ ? "," : "", b.module.c_str(), b.variant.c_str());
+		fprintf(file, "\"n\": %d, \"thd_n_db\": %.2f, \"gain_deviation_db\": %.3f, ",
+				b.control_rate, thd_n_db, deviation_db);
+		fprintf(file, "\"ns_per_sample\": %.4f}", ns);
+	}
+	fprintf(file, "\n  ]\n}\n");
+	if (o.out) fclose(file);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	bench_options o;
+	if (!bench_parse_options(o, argc, argv)) {
+		fprintf(stderr, "usage: trnr-bench [--filter module] [--rates 44100,48000] "
+						"[--blocks 64,256] [--channels 1,2] [--seconds 0.25] "
+						"[--repeats 3] [--no-ftz] [--out results.json] [--alias] "
+						"[--control-rate]\n");
+		return 1;
+	}
+
+	// the mode a host runs its audio callback in
+	uint64_t saved_fp_state = o.ftz ? denormal_flush_begin() : 0;
+
+	vector<bench_case> cases = bench_cases();
+
+	if (o.alias) {
+		int code = bench_alias(cases, o);
+		if (o.ftz) denormal_flush_end(saved_fp_state);
+		return code;
+	}
+
+	if (o.control_rate) {
+		int code = bench_control_rate(cases, o);
+		if (o.ftz) denormal_flush_end(saved_fp_state);
+		return code;
+	}
+
+	vector<bench_result> results;
+
+	for (const bench_case& b : cases) {
+		if (!o.filter.empty() && b.module.find(o.filter) == string::npos) continue;
+
+		for (double samplerate : o.samplerates)
+			for (double block_size : o.block_sizes)
+				for (double channels : o.channels) {
+					bench_config c {samplerate, (int)block_size, (int)channels};
+					if (c.block_size < 1 || c.channels < 1) continue;
+
+					bench_process process = b.setup(c);
+					if (!process) continue;
+
+					bench_result r = bench_run(b, c, process, o);
+					results.push_back(r);
+
+					double samples = (double)r.frames * c.channels;
+					fprintf(stderr, "%-14s %-20s %6.0f Hz %5d frames %2d ch",
+							b.module.c_str(), b.variant.c_str(), c.samplerate,
+							c.block_size, c.channels);
+					fprintf(stderr, " %9.3f ns/sample", r.ns / samples);
+#ifdef TRNR_BENCH_RDTSC
+					fprintf(stderr, " %9.3f cycles/sample", r.cycles / samples);
+#endif
+					fprintf(stderr, "\n");
+				}
+	}
+
+	if (o.ftz) denormal_flush_end(saved_fp_state);
+
+	FILE* file = o.out ? fopen(o.out, "w") : stdout;
+	if (!file) {
+		fprintf(stderr, "trnr-bench: cannot write %s\n", o.out);
+		return 1;
+	}
+	bench_write_json(file, results, o);
+	if (o.out) fclose(file);
+	return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * adaa.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+
+namespace trnr {
+
+// First order antiderivative anti-aliasing. Instead of f(x[n]) the output is the mean
+// of f between the last two inputs, (F(x[n]) - F(x[n - 1])) / (x[n] - x[n - 1]),
+// which removes most of the aliasing of hard corners at the base samplerate.
+// Adds half a sample of latency.
+
+// below this input difference the mean is taken as f((x[n] + x[n - 1]) / 2)
+constexpr double ADAA_TOLERANCE = 1e-6;
+
+// per channel state
+struct adaa_state {
+	double x1 = 0.0;  // last input
+	double ad1 = 0.0; // antiderivative of the last input
+};
+
+// f is the nonlinearity, ad its antiderivative
+template <typename function, typename antiderivative>
+inline double adaa_process(adaa_state& s, double x, function f, antiderivative ad)
+{
+	double ad0 = ad(x);
+	double dx = x - s.x1;
+	double y = std::fabs(dx) < ADAA_TOLERANCE ? f(0.5 * (x + s.x1)) : (ad0 - s.ad1) / dx;
+	s.x1 = x;
+	s.ad1 = ad0;
+	return y;
+}
+
+// resets the state to a resting input, avoids a click when the first block starts
+template <typename antiderivative>
+inline void adaa_reset(adaa_state& s, double x, antiderivative ad)
+{
+	s.x1 = x;
+	s.ad1 = ad(x);
+}
+
+///////////////
+// HARD CLIP //
+///////////////
+
+inline double adaa_hard_clip_curve(double x)
+{
+	return x > 1.0 ? 1.0 : x < -1.0 ? -1.0 : x;
+}
+
+inline double adaa_hard_clip_antiderivative(double x)
+{
+	double a = std::fabs(x);
+	return a <= 1.0 ? 0.5 * x * x : a - 0.5;
+}
+
+// clips to -1..1, scale the input to set the drive
+template <typename t_sample>
+inline void adaa_hard_clip_block(adaa_state& s, t_sample* audio, int frames)
+{
+	for (int i = 0; i < frames; i++) {
+		audio[i] = adaa_process(s, audio[i], adaa_hard_clip_curve,
+								adaa_hard_clip_antiderivative);
+	}
+}
+
+//////////
+// FOLD //
+//////////
+
+// same curve as fold(), a triangle wave with period 4 through the origin
+inline double adaa_fold_curve(double x)
+{
+	double w = x + 1.0 - 4.0 * std::floor((x + 1.0) * 0.25) - 2.0;
+	return 1.0 - std::fabs(w);
+}
+
+// w - w * |w| / 2 with w = ((x + 1) mod 4) - 2, periodic because every period
+// integrates to zero
+inline double adaa_fold_antiderivative(double x)
+{
+	double w = x + 1.0 - 4.0 * std::floor((x + 1.0) * 0.25) - 2.0;
+	return w - 0.5 * w * std::fabs(w);
+}
+
+// same curve as fold_bipolar(): equals fold(x) up to |x| = 2, -fold(x) beyond
+inline double adaa_fold_bipolar_curve(double x)
+{
+	double y = adaa_fold_curve(std::fabs(2.0 - std::fabs(x)));
+	return x < 0.0 ? -y : y;
+}
+
+// even, from the fold antiderivative over 0..|x|
+inline double adaa_fold_bipolar_antiderivative(double x)
+{
+	double a = std::fabs(x);
+	if (a <= 2.0) return adaa_fold_antiderivative(a) + 0.5;
+	return 1.5 - adaa_fold_antiderivative(a);
+}
+
+template <typename t_sample>
+inline void adaa_fold_block(adaa_state& s, t_sample* audio, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		audio[i] = adaa_process(s, audio[i], adaa_fold_curve, adaa_fold_antiderivative);
+}
+
+template <typename t_sample>
+inline void adaa_fold_bipolar_block(adaa_state& s, t_sample* audio, int frames)
+{
+	for (int i = 0; i < frames; i++) {
+		audio[i] = adaa_process(s, audio[i], adaa_fold_bipolar_curve,
+								adaa_fold_bipolar_antiderivative);
+	}
+}
+
+//////////////////////////////
+// TABULATED ANTIDERIVATIVE //
+//////////////////////////////
+
+constexpr int ADAA_TABLE_SIZE = 256;
+
+// Antiderivative of a curve without closed form that is constant outside lo..hi (the
+// input is clamped before the curve). Stores F and f at the knots and interpolates F
+// with a cubic hermite, f being the exact slope.
+struct adaa_table {
+	double lo = -1.0;
+	double hi = 1.0;
+	double step = 2.0 / ADAA_TABLE_SIZE;
+	std::array<double, ADAA_TABLE_SIZE + 1> ad;
+	std::array<double, ADAA_TABLE_SIZE + 1> curve;
+};
+
+// integrates f with simpson's rule on every table interval, not realtime safe for
+// expensive curves
+template <typename function>
+inline void adaa_table_build(adaa_table& t, function f, double lo, double hi)
+{
+	t.lo = lo;
+	t.hi = hi;
+	t.step = (hi - lo) / ADAA_TABLE_SIZE;
+
+	const int substeps = 8;
+	const double h = t.step / substeps;
+
+	t.ad[0] = 0.0;
+	t.curve[0] = f(lo);
+	for (int i = 1; i <= ADAA_TABLE_SIZE; i++) {
+		double x0 = lo + (i - 1) * t.step;
+		double sum = f(x0) + f(x0 + t.step);
+		for (int j = 1; j < substeps; j++) sum += (j % 2 ? 4.0 : 2.0) * f(x0 + j * h);
+		t.ad[i] = t.ad[i - 1] + sum * h / 3.0;
+		t.curve[i] = f(lo + i * t.step);
+	}
+}
+
+inline double adaa_table_antiderivative(const adaa_table& t, double x)
+{
+	// linear beyond the table, the curve is constant there
+	if (x <= t.lo) return t.ad[0] + t.curve[0] * (x - t.lo);
+	if (x >= t.hi) return t.ad[ADAA_TABLE_SIZE] + t.curve[ADAA_TABLE_SIZE] * (x - t.hi);
+
+	double pos = (x - t.lo) / t.step;
+	int i = (int)pos;
+	if (i >= ADAA_TABLE_SIZE) i = ADAA_TABLE_SIZE - 1;
+	double u = pos - i;
+
+	// cubic hermite basis
+	double u2 = u * u;
+	double u3 = u2 * u;
+	double h00 = 2.0 * u3 - 3.0 * u2 + 1.0;
+	double h10 = u3 - 2.0 * u2 + u;
+	double h01 = -2.0 * u3 + 3.0 * u2;
+	double h11 = u3 - u2;
+
+	return h00 * t.ad[i] + h10 * t.step * t.curve[i] + h01 * t.ad[i + 1] +
+		   h11 * t.step * t.curve[i + 1];
+}
+} // namespace trnr
@@ -35,126 +35,111 @@
 #include <cstdlib>
 
 namespace trnr {
-struct clip {
+template <size_t channels>
+struct clip_n {
 	double samplerate;
 
-	double last_sample_l;
-	double intermediate_l[16];
-	bool was_pos_clip_l;
-	bool was_neg_clip_l;
+	// per channel state
+	double last_sample[channels];
+	double intermediate[channels][16];
+	bool was_pos_clip[channels];
+	bool was_neg_clip[channels];
 
-	double last_sample_r;
-	double intermediate_r[16];
-	bool was_pos_clip_r;
-	bool was_neg_clip_r;
+	// latency line, ring buffer over intermediate
+	int spacing;
+	int intermediate_pos;
 };
 
-inline void clip_init(clip& c, double _samplerate)
+using clip = clip_n<2>;
+
+// one 44.1k sample in samples at the current samplerate, 1 to 16
+inline int clip_spacing(double samplerate)
 {
-	c.samplerate = 44100;
-
-	c.last_sample_l = 0.0;
-	c.was_pos_clip_l = false;
-	c.was_neg_clip_l = false;
-	c.last_sample_r = 0.0;
-	c.was_pos_clip_r = false;
-	c.was_neg_clip_r = false;
-
-	for (int x = 0; x < 16; x++) {
-		c.intermediate_l[x] = 0.0;
-		c.intermediate_r[x] = 0.0;
-	}
+	int spacing = floor(samplerate / 44100.0);
+	if (spacing < 1) spacing = 1;
+	if (spacing > 16) spacing = 16;
+	return spacing;
 }
 
-template <typename t_sample>
-inline void clip_process_block(clip& c, t_sample** inputs, t_sample** outputs,
-							   long sample_frames)
+template <size_t channels>
+inline void clip_init(clip_n<channels>& c, double _samplerate)
 {
-	t_sample* in1 = inputs[0];
-	t_sample* in2 = inputs[1];
-	t_sample* out1 = outputs[0];
-	t_sample* out2 = outputs[1];
+	c.samplerate = _samplerate;
+	c.spacing = clip_spacing(c.samplerate);
+	c.intermediate_pos = 0;
 
-	double overallscale = 1.0;
-	overallscale /= 44100.0;
-	overallscale *= c.samplerate;
+	for (size_t ch = 0; ch < channels; ++ch) {
+		c.last_sample[ch] = 0.0;
+		c.was_pos_clip[ch] = false;
+		c.was_neg_clip[ch] = false;
 
-	int spacing =
-		floor(overallscale); // should give us working basic scaling, usually 2 or 4
-	if (spacing < 1) spacing = 1;
-	if (spacing > 16) spacing = 16;
+		for (int x = 0; x < 16; x++) c.intermediate[ch][x] = 0.0;
+	}
+}
 
-	while (--sample_frames >= 0) {
-		double input_l = *in1;
-		double input_r = *in2;
-
-		// begin ClipOnly2 stereo as a little, compressed chunk that can be dropped into
-		// code
-		if (input_l > 4.0) input_l = 4.0;
-		if (input_l < -4.0) input_l = -4.0;
-		if (c.was_pos_clip_l == true) { // current will be over
-			if (input_l < c.last_sample_l)
-				c.last_sample_l = 0.7058208 + (input_l * 0.2609148);
-			else c.last_sample_l = 0.2491717 + (c.last_sample_l * 0.7390851);
-		}
-		c.was_pos_clip_l = false;
-		if (input_l > 0.9549925859) {
-			c.was_pos_clip_l = true;
-			input_l = 0.7058208 + (c.last_sample_l * 0.2609148);
-		}
-		if (c.was_neg_clip_l == true) { // current will be -over
-			if (input_l > c.last_sample_l)
-				c.last_sample_l = -0.7058208 + (input_l * 0.2609148);
-			else c.last_sample_l = -0.2491717 + (c.last_sample_l * 0.7390851);
-		}
-		c.was_neg_clip_l = false;
-		if (input_l < -0.9549925859) {
-			c.was_neg_clip_l = true;
-			input_l = -0.7058208 + (c.last_sample_l * 0.2609148);
-		}
-		c.intermediate_l[spacing] = input_l;
-		input_l =
-			c.last_sample_l; // Latency is however many samples equals one 44.1k sample
-		for (int x = spacing; x > 0; x--) c.intermediate_l[x - 1] = c.intermediate_l[x];
-		c.last_sample_l = c.intermediate_l[0]; // run a little buffer to handle this
-
-		if (input_r > 4.0) input_r = 4.0;
-		if (input_r < -4.0) input_r = -4.0;
-		if (c.was_pos_clip_r == true) { // current will be over
-			if (input_r < c.last_sample_r)
-				c.last_sample_r = 0.7058208 + (input_r * 0.2609148);
-			else c.last_sample_r = 0.2491717 + (c.last_sample_r * 0.7390851);
-		}
-		c.was_pos_clip_r = false;
-		if (input_r > 0.9549925859) {
-			c.was_pos_clip_r = true;
-			input_r = 0.7058208 + (c.last_sample_r * 0.2609148);
-		}
-		if (c.was_neg_clip_r == true) { // current will be -over
-			if (input_r > c.last_sample_r)
-				c.last_sample_r = -0.7058208 + (input_r * 0.2609148);
-			else c.last_sample_r = -0.2491717 + (c.last_sample_r * 0.7390851);
-		}
-		c.was_neg_clip_r = false;
-		if (input_r < -0.9549925859) {
-			c.was_neg_clip_r = true;
-			input_r = -0.7058208 + (c.last_sample_r * 0.2609148);
+// latency in samples the host has to compensate
+template <size_t channels>
+inline int clip_latency(const clip_n<channels>& c)
+{
+	return c.spacing;
+}
+
+// each input sample is read before its output is written, inputs may equal outputs
+template <typename t_sample, size_t channels>
+inline void clip_process_block(clip_n<channels>& c, t_sample** inputs, t_sample** outputs,
+							   long sample_frames)
+{
+	// the line holds spacing - 1 samples, last_sample adds one more
+	const int delay = c.spacing - 1;
+
+	for (size_t ch = 0; ch < channels; ++ch) {
+		t_sample* in = inputs[ch];
+		t_sample* out = outputs[ch];
+
+		double& last_sample = c.last_sample[ch];
+		double* intermediate = c.intermediate[ch];
+		bool& was_pos_clip = c.was_pos_clip[ch];
+		bool& was_neg_clip = c.was_neg_clip[ch];
+		int pos = c.intermediate_pos;
+
+		for (long i = 0; i < sample_frames; ++i) {
+			int read = (pos - delay) & 15;
+
+			double input = in[i];
+
+			// begin ClipOnly2 as a little, compressed chunk that can be dropped into code
+			if (input > 4.0) input = 4.0;
+			if (input < -4.0) input = -4.0;
+			if (was_pos_clip == true) { // current will be over
+				if (input < last_sample) last_sample = 0.7058208 + (input * 0.2609148);
+				else last_sample = 0.2491717 + (last_sample * 0.7390851);
+			}
+			was_pos_clip = false;
+			if (input > 0.9549925859) {
+				was_pos_clip = true;
+				input = 0.7058208 + (last_sample * 0.2609148);
+			}
+			if (was_neg_clip == true) { // current will be -over
+				if (input > last_sample) last_sample = -0.7058208 + (input * 0.2609148);
+				else last_sample = -0.2491717 + (last_sample * 0.7390851);
+			}
+			was_neg_clip = false;
+			if (input < -0.9549925859) {
+				was_neg_clip = true;
+				input = -0.7058208 + (last_sample * 0.2609148);
+			}
+			intermediate[pos] = input;
+			// Latency is however many samples equals one 44.1k sample
+			input = last_sample;
+			last_sample = intermediate[read]; // run a little buffer to handle this
+			// end ClipOnly2 as a little, compressed chunk that can be dropped into code
+
+			pos = (pos + 1) & 15;
+
+			out[i] = input;
 		}
-		c.intermediate_r[spacing] = input_r;
-		input_r =
-			c.last_sample_r; // Latency is however many samples equals one 44.1k sample
-		for (int x = spacing; x > 0; x--) c.intermediate_r[x - 1] = c.intermediate_r[x];
-		c.last_sample_r = c.intermediate_r[0]; // run a little buffer to handle this
-		// end ClipOnly2 stereo as a little, compressed chunk that can be dropped into
-		// code
-
-		*out1 = input_l;
-		*out2 = input_r;
-
-		in1++;
-		in2++;
-		out1++;
-		out2++;
 	}
+
+	c.intermediate_pos = (c.intermediate_pos + sample_frames) & 15;
 }
 } // namespace trnr
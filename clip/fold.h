@@ -23,41 +23,128 @@
 
 #pragma once
 
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRNR_FOLD_SSE2
+#endif
+
 namespace trnr {
+// floats beyond 2^22 cannot resolve a fold anymore, larger inputs are clamped
+constexpr float FOLD_MAX_INPUT = 4194304.f;
+
+// floor that compiles to plain SSE2/NEON instructions, valid for |x| < 2^31
+inline float fold_floor(float x)
+{
+	float truncated = (float)(int)x;
+	return truncated > x ? truncated - 1.f : truncated;
+}
+
+// Folds x into -1..1 in constant time. The folded wave is a triangle wave with period
+// 4 through the origin: 1 - |((x + 1) mod 4) - 2|. Inside -1..1 x is returned as is,
+// so small signals keep their full precision.
+inline float fold_closed(float x)
+{
+	float clamped = x > FOLD_MAX_INPUT ? FOLD_MAX_INPUT : x;
+	clamped = clamped < -FOLD_MAX_INPUT ? -FOLD_MAX_INPUT : clamped;
+
+	float shifted = clamped + 1.f;
+	float w = shifted - 4.f * fold_floor(shifted * 0.25f) - 2.f;
+	float folded = 1.f - (w < 0.f ? -w : w);
+
+	float magnitude = x < 0.f ? -x : x;
+	return magnitude <= 1.f ? x : folded;
+}
+
+// fold_bipolar in constant time: sign(x) * fold(|2 - |x||) for |x| > 1
+inline float fold_bipolar_closed(float x)
+{
+	float magnitude = x < 0.f ? -x : x;
+	float distance = 2.f - magnitude;
+	float folded = fold_closed(distance < 0.f ? -distance : distance);
+	folded = x < 0.f ? -folded : folded;
+	return magnitude <= 1.f ? x : folded;
+}
+
 // folds the wave from -1 to 1
 inline float fold(float& sample)
 {
-	while (sample > 1.0 || sample < -1.0) {
-
-		if (sample > 1.0) {
-			sample = 2.0 - sample;
-		} else if (sample < -1.0) {
-			sample = -2.0 - sample;
-		}
-	}
+	sample = fold_closed(sample);
 	return sample;
 }
 
 // folds the positive part of the wave independently from the negative part.
 inline float fold_bipolar(float& sample)
 {
-	// fold positive values
-	if (sample > 1.0) {
-		sample = 2.0 - sample;
+	sample = fold_bipolar_closed(sample);
+	return sample;
+}
 
-		if (sample < 0.0) { sample = -sample; }
+#ifdef TRNR_FOLD_SSE2
+// four lanes of fold_closed
+inline __m128 fold_closed_sse2(__m128 x)
+{
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 max = _mm_set1_ps(FOLD_MAX_INPUT);
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
 
-		return fold(sample);
-	}
-	// fold negative values
-	else if (sample < -1.0) {
-		sample = -2.0 - sample;
+	__m128 clamped = _mm_min_ps(_mm_max_ps(x, _mm_sub_ps(_mm_setzero_ps(), max)), max);
+	__m128 shifted = _mm_add_ps(clamped, one);
+	__m128 quarter = _mm_mul_ps(shifted, _mm_set1_ps(0.25f));
+	__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(quarter));
+	__m128 above = _mm_and_ps(_mm_cmpgt_ps(truncated, quarter), one);
+	__m128 floored = _mm_sub_ps(truncated, above);
+
+	__m128 w = _mm_sub_ps(_mm_sub_ps(shifted, _mm_mul_ps(_mm_set1_ps(4.f), floored)),
+						  _mm_set1_ps(2.f));
+	__m128 folded = _mm_sub_ps(one, _mm_and_ps(w, abs_mask));
+
+	__m128 inside = _mm_cmple_ps(_mm_and_ps(x, abs_mask), one);
+	return _mm_or_ps(_mm_and_ps(inside, x), _mm_andnot_ps(inside, folded));
+}
+
+// four lanes of fold_bipolar_closed
+inline __m128 fold_bipolar_closed_sse2(__m128 x)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
 
-		if (sample > 0.0) { sample = -sample; }
+	__m128 magnitude = _mm_and_ps(x, abs_mask);
+	__m128 distance = _mm_and_ps(_mm_sub_ps(_mm_set1_ps(2.f), magnitude), abs_mask);
+	__m128 sign = _mm_andnot_ps(abs_mask, x);
+	__m128 folded = _mm_xor_ps(fold_closed_sse2(distance), sign);
 
-		return fold(sample);
-	} else {
-		return sample;
+	__m128 inside = _mm_cmple_ps(magnitude, _mm_set1_ps(1.f));
+	return _mm_or_ps(_mm_and_ps(inside, x), _mm_andnot_ps(inside, folded));
+}
+#endif
+
+// branch free, same cost at any drive, four samples at a time for float buffers on sse2
+template <typename t_sample>
+inline void fold_block(t_sample* audio, int frames)
+{
+	int i = 0;
+#ifdef TRNR_FOLD_SSE2
+	if constexpr (std::is_same<t_sample, float>::value) {
+		for (; i + 4 <= frames; i += 4)
+			_mm_storeu_ps(audio + i, fold_closed_sse2(_mm_loadu_ps(audio + i)));
+	}
+#endif
+	for (; i < frames; i++) audio[i] = fold_closed((float)audio[i]);
+}
+
+template <typename t_sample>
+inline void fold_bipolar_block(t_sample* audio, int frames)
+{
+	int i = 0;
+#ifdef TRNR_FOLD_SSE2
+	if constexpr (std::is_same<t_sample, float>::value) {
+		for (; i + 4 <= frames; i += 4) {
+			__m128 folded = fold_bipolar_closed_sse2(_mm_loadu_ps(audio + i));
+			_mm_storeu_ps(audio + i, folded);
+		}
 	}
+#endif
+	for (; i < frames; i++) audio[i] = fold_bipolar_closed((float)audio[i]);
 }
 }; // namespace trnr
@@ -31,6 +31,8 @@
 
 #pragma once
 
+#include "../util/random.h"
+#include "adaa.h"
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
@@ -40,192 +42,296 @@ using namespace std;
 
 namespace trnr {
 
-struct tube {
+// powerfactor range set by tube_amt
+constexpr int TUBE_POWERFACTORS = 10;
+
+template <size_t channels>
+struct tube_n {
 	double samplerate;
 
-	double prev_sample_a;
-	double prev_sample_b;
-	double prev_sample_c;
-	double prev_sample_d;
-	double prev_sample_e;
-	double prev_sample_f;
+	// per channel state of the averaging (high samplerates) and hysteresis stages
+	double prev_input[channels];
+	double prev_curve[channels];
+	double prev_hysteresis[channels];
 
-	uint32_t fdp_l;
-	uint32_t fdp_r;
+	uint32_t fdp[channels];
 
 	float input_vol;
 	float tube_amt;
 
+	// antiderivative anti-aliasing of the static curve (see tube_curve) and output clamp
+	bool adaa = false;
+	int adaa_powerfactor = 0; // the shaper state was last reset for
+	adaa_table adaa_curves[TUBE_POWERFACTORS]; // one per powerfactor, built in tube_init
+	adaa_state adaa_shaper[channels];
+	adaa_state adaa_clamp[channels];
+
 	void set_input(double value) { input_vol = clamp(value, 0.0, 1.0); }
 
 	void set_tube(double value) { tube_amt = clamp(value, 0.0, 1.0); }
 };
 
-inline void tube_init(tube& t, double samplerate)
+using tube = tube_n<2>;
+
+// x^n by squaring, unrolled at compile time
+template <int n>
+inline double tube_pow(double x)
+{
+	if constexpr (n == 0) return 1.0;
+	else if constexpr (n % 2 == 0) {
+		double half = tube_pow<n / 2>(x);
+		return half * half;
+	} else return x * tube_pow<n - 1>(x);
+}
+
+// Original Tube algorithm: x^(powerfactor + 1), the sign is kept for odd powerfactors.
+// Same as multiplying x powerfactor times and replacing one x with |x| if odd.
+template <int powerfactor>
+inline double tube_factor(double x)
+{
+	if constexpr (powerfactor % 2 == 1) return tube_pow<powerfactor>(x) * fabs(x);
+	else return tube_pow<powerfactor>(x) * x;
+}
+
+// sqrt(|x|) with the sign of x, branchless
+inline double tube_signed_sqrt(double x) { return copysign(sqrt(fabs(x)), x); }
+
+// static part of the tube: clamp, asymmetric sharpen and the power waveshaper
+template <int powerfactor>
+inline double tube_curve(double input)
+{
+	constexpr double asym_pad = (double)powerfactor;
+	constexpr double asym_pad_inv = 1.0 / asym_pad;
+	constexpr double gainscaling = 1.0 / (double)(powerfactor + 1);
+	constexpr double outputscaling = 1.0 + (1.0 / (double)(powerfactor));
+
+	if (input > 1.0) input = 1.0;
+	if (input < -1.0) input = -1.0;
+
+	// flatten bottom, point top of sine waveshaper
+	input *= asym_pad_inv;
+	double sharpen = 1.0 + tube_signed_sqrt(-input);
+	input -= input * fabs(input) * sharpen * 0.25;
+	// this will take input from exactly -1.0 to 1.0 max
+	input *= asym_pad;
+	// end first asym section: later boosting can mitigate the extreme
+	// softclipping of one side of the wave
+	// and we are asym clipping more when Tube is cranked, to compensate
+
+	// original Tube algorithm: powerfactor widens the more linear region of the wave
+	double factor = tube_factor<powerfactor>(input);
+	factor *= gainscaling;
+	input -= factor;
+	input *= outputscaling;
+	return input;
+}
+
+template <int powerfactor>
+inline double tube_curve_adaa(const adaa_table& table, adaa_state& s, double input)
+{
+	return adaa_process(s, input, tube_curve<powerfactor>, [&table](double x) {
+		return adaa_table_antiderivative(table, x);
+	});
+}
+
+// builds the antiderivative tables of the static curve for all powerfactors
+template <size_t channels>
+inline void tube_build_adaa_tables(tube_n<channels>& t)
+{
+	adaa_table* curves = t.adaa_curves;
+	adaa_table_build(curves[0], tube_curve<1>, -1.0, 1.0);
+	adaa_table_build(curves[1], tube_curve<2>, -1.0, 1.0);
+	adaa_table_build(curves[2], tube_curve<3>, -1.0, 1.0);
+	adaa_table_build(curves[3], tube_curve<4>, -1.0, 1.0);
+	adaa_table_build(curves[4], tube_curve<5>, -1.0, 1.0);
+	adaa_table_build(curves[5], tube_curve<6>, -1.0, 1.0);
+	adaa_table_build(curves[6], tube_curve<7>, -1.0, 1.0);
+	adaa_table_build(curves[7], tube_curve<8>, -1.0, 1.0);
+	adaa_table_build(curves[8], tube_curve<9>, -1.0, 1.0);
+	adaa_table_build(curves[9], tube_curve<10>, -1.0, 1.0);
+}
+
+template <size_t channels>
+inline void tube_init(tube_n<channels>& t, double samplerate)
 {
 	t.samplerate = 44100;
 
 	t.input_vol = 0.5;
 	t.tube_amt = 0.5;
-	t.prev_sample_a = 0.0;
-	t.prev_sample_b = 0.0;
-	t.prev_sample_c = 0.0;
-	t.prev_sample_d = 0.0;
-	t.prev_sample_e = 0.0;
-	t.prev_sample_f = 0.0;
-	t.fdp_l = 1.0;
-	while (t.fdp_l < 16386) t.fdp_l = rand() * UINT32_MAX;
-	t.fdp_r = 1.0;
-	while (t.fdp_r < 16386) t.fdp_r = rand() * UINT32_MAX;
+	t.adaa_powerfactor = 0;
+
+	for (size_t ch = 0; ch < channels; ++ch) {
+		t.prev_input[ch] = 0.0;
+		t.prev_curve[ch] = 0.0;
+		t.prev_hysteresis[ch] = 0.0;
+		t.fdp[ch] = prng_fpd_seed();
+
+		t.adaa_shaper[ch] = adaa_state {};
+		t.adaa_clamp[ch] = adaa_state {};
+	}
+
+	// all tables up front, tube_amt can change the powerfactor on the audio thread
+	tube_build_adaa_tables(t);
 }
 
-template <typename t_sample>
-inline void tube_process_block(tube& t, t_sample** inputs, t_sample** outputs,
-							   long sampleframes)
+// the dither is seeded differently on init, a fixed seed makes the output repeatable
+template <size_t channels>
+inline void tube_seed(tube_n<channels>& t, uint32_t seed)
 {
-	t_sample* in1 = inputs[0];
-	t_sample* in2 = inputs[1];
-	t_sample* out1 = outputs[0];
-	t_sample* out2 = outputs[1];
+	prng r;
+	prng_init(r, seed);
+	for (size_t ch = 0; ch < channels; ++ch) t.fdp[ch] = prng_fpd_seed(r);
+}
 
+// each input sample is read before its output is written, inputs may equal outputs
+template <int powerfactor, bool adaa, typename t_sample, size_t channels>
+inline void tube_process_kernel(tube_n<channels>& t, t_sample** inputs,
+								t_sample** outputs, long sampleframes)
+{
 	double overallscale = 1.0;
 	overallscale /= 44100.0;
 	overallscale *= t.samplerate;
 
 	double input_pad = t.input_vol;
-	double iterations = 1.0 - t.tube_amt;
-	int powerfactor = (9.0 * iterations) + 1;
-	double asym_pad = (double)powerfactor;
 	double gainscaling = 1.0 / (double)(powerfactor + 1);
-	double outputscaling = 1.0 + (1.0 / (double)(powerfactor));
 
-	while (--sampleframes >= 0) {
-		double input_l = *in1;
-		double input_r = *in2;
-		if (fabs(input_l) < 1.18e-23) input_l = t.fdp_l * 1.18e-17;
-		if (fabs(input_r) < 1.18e-23) input_r = t.fdp_r * 1.18e-17;
+	for (size_t ch = 0; ch < channels; ++ch) {
+		t_sample* in = inputs[ch];
+		t_sample* out = outputs[ch];
+
+		double& prev_input = t.prev_input[ch];
+		double& prev_curve = t.prev_curve[ch];
+		double& prev_hysteresis = t.prev_hysteresis[ch];
+		uint32_t& fdp = t.fdp[ch];
+
+		for (long i = 0; i < sampleframes; ++i) {
+			double input = in[i];
+#ifndef TRNR_ASSUME_FTZ
+			if (fabs(input) < 1.18e-23) input = fdp * 1.18e-17;
+#endif
+
+			if (input_pad < 1.0) input *= input_pad;
 
-		if (input_pad < 1.0) {
-			input_l *= input_pad;
-			input_r *= input_pad;
+			if (overallscale > 1.9) {
+				double stored = input;
+				input += prev_input;
+				prev_input = stored;
+				input *= 0.5;
+			} // for high sample rates on this plugin we are going to do a simple average
+
+			if constexpr (adaa) {
+				adaa_state& state = t.adaa_shaper[ch];
+				const adaa_table& table = t.adaa_curves[powerfactor - 1];
+				input = tube_curve_adaa<powerfactor>(table, state, input);
+			} else {
+				input = tube_curve<powerfactor>(input);
+			}
+
+			if (overallscale > 1.9) {
+				double stored = input;
+				input += prev_curve;
+				prev_curve = stored;
+				input *= 0.5;
+			} // for high sample rates on this plugin we are going to do a simple average
+			// end original Tube. Now we have a boosted fat sound peaking at 0dB exactly
+
+			// hysteresis and spiky fuzz
+			double slew = prev_hysteresis - input;
+			if (overallscale > 1.9) {
+				double stored = input;
+				input += prev_hysteresis;
+				prev_hysteresis = stored;
+				input *= 0.5;
+			} else prev_hysteresis = input; // for this, need previousSampleC always
+			slew = 1.0 + tube_signed_sqrt(slew) * 0.5;
+			input -= input * fabs(input) * slew * gainscaling;
+			// reusing gainscaling that's part of another algorithm
+			if constexpr (adaa) {
+				input = adaa_process(t.adaa_clamp[ch], input * 1.923076923076923,
+									 adaa_hard_clip_curve, adaa_hard_clip_antiderivative);
+			} else {
+				if (input > 0.52) input = 0.52;
+				if (input < -0.52) input = -0.52;
+				input *= 1.923076923076923;
+			}
+			// end hysteresis and spiky fuzz section
+
+			// begin 64 bit floating point dither
+			// int expon; frexp((double)inputSample, &expon);
+			fdp ^= fdp << 13;
+			fdp ^= fdp >> 17;
+			fdp ^= fdp << 5;
+			// inputSample += ((double(fpd)-uint32_t(0x7fffffff)) * 1.1e-44l *
+			// pow(2,expon+62)); end 64 bit floating point dither
+
+			out[i] = input;
 		}
+	}
+}
+
+// dispatches to the kernel for the current powerfactor (1 to 10)
+template <bool adaa, typename t_sample, size_t channels>
+inline void tube_dispatch(tube_n<channels>& t, int powerfactor, t_sample** inputs,
+						  t_sample** outputs, long sampleframes)
+{
+	switch (powerfactor) {
+	case 1:
+		tube_process_kernel<1, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	case 2:
+		tube_process_kernel<2, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	case 3:
+		tube_process_kernel<3, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	case 4:
+		tube_process_kernel<4, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	case 5:
+		tube_process_kernel<5, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	case 6:
+		tube_process_kernel<6, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	case 7:
+		tube_process_kernel<7, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	case 8:
+		tube_process_kernel<8, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	case 9:
+		tube_process_kernel<9, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	default:
+		tube_process_kernel<10, adaa>(t, inputs, outputs, sampleframes);
+		break;
+	}
+}
+
+// switches the shaper to the table of the powerfactor, the tables have different
+// integration constants so the antiderivative of the last input is looked up again
+template <size_t channels>
+inline void tube_select_adaa_table(tube_n<channels>& t, int powerfactor)
+{
+	const adaa_table& table = t.adaa_curves[powerfactor - 1];
+	auto ad = [&table](double x) { return adaa_table_antiderivative(table, x); };
+	for (size_t ch = 0; ch < channels; ++ch)
+		adaa_reset(t.adaa_shaper[ch], t.adaa_shaper[ch].x1, ad);
+	t.adaa_powerfactor = powerfactor;
+}
+
+template <typename t_sample, size_t channels>
+inline void tube_process_block(tube_n<channels>& t, t_sample** inputs, t_sample** outputs,
+							   long sampleframes)
+{
+	double iterations = 1.0 - t.tube_amt;
+	int powerfactor = (9.0 * iterations) + 1;
 
-		if (overallscale > 1.9) {
-			double stored = input_l;
-			input_l += t.prev_sample_a;
-			t.prev_sample_a = stored;
-			input_l *= 0.5;
-			stored = input_r;
-			input_r += t.prev_sample_b;
-			t.prev_sample_b = stored;
-			input_r *= 0.5;
-		} // for high sample rates on this plugin we are going to do a simple average
-
-		if (input_l > 1.0) input_l = 1.0;
-		if (input_l < -1.0) input_l = -1.0;
-		if (input_r > 1.0) input_r = 1.0;
-		if (input_r < -1.0) input_r = -1.0;
-
-		// flatten bottom, point top of sine waveshaper L
-		input_l /= asym_pad;
-		double sharpen = -input_l;
-		if (sharpen > 0.0) sharpen = 1.0 + sqrt(sharpen);
-		else sharpen = 1.0 - sqrt(-sharpen);
-		input_l -= input_l * fabs(input_l) * sharpen * 0.25;
-		// this will take input from exactly -1.0 to 1.0 max
-		input_l *= asym_pad;
-		// flatten bottom, point top of sine waveshaper R
-		input_r /= asym_pad;
-		sharpen = -input_r;
-		if (sharpen > 0.0) sharpen = 1.0 + sqrt(sharpen);
-		else sharpen = 1.0 - sqrt(-sharpen);
-		input_r -= input_r * fabs(input_r) * sharpen * 0.25;
-		// this will take input from exactly -1.0 to 1.0 max
-		input_r *= asym_pad;
-		// end first asym section: later boosting can mitigate the extreme
-		// softclipping of one side of the wave
-		// and we are asym clipping more when Tube is cranked, to compensate
-
-		// original Tube algorithm: powerfactor widens the more linear region of the wave
-		double factor = input_l; // Left channel
-		for (int x = 0; x < powerfactor; x++) factor *= input_l;
-		if ((powerfactor % 2 == 1) && (input_l != 0.0))
-			factor = (factor / input_l) * fabs(input_l);
-		factor *= gainscaling;
-		input_l -= factor;
-		input_l *= outputscaling;
-		factor = input_r; // Right channel
-		for (int x = 0; x < powerfactor; x++) factor *= input_r;
-		if ((powerfactor % 2 == 1) && (input_r != 0.0))
-			factor = (factor / input_r) * fabs(input_r);
-		factor *= gainscaling;
-		input_r -= factor;
-		input_r *= outputscaling;
-
-		if (overallscale > 1.9) {
-			double stored = input_l;
-			input_l += t.prev_sample_c;
-			t.prev_sample_c = stored;
-			input_l *= 0.5;
-			stored = input_r;
-			input_r += t.prev_sample_d;
-			t.prev_sample_d = stored;
-			input_r *= 0.5;
-		} // for high sample rates on this plugin we are going to do a simple average
-		// end original Tube. Now we have a boosted fat sound peaking at 0dB exactly
-
-		// hysteresis and spiky fuzz L
-		double slew = t.prev_sample_e - input_l;
-		if (overallscale > 1.9) {
-			double stored = input_l;
-			input_l += t.prev_sample_e;
-			t.prev_sample_e = stored;
-			input_l *= 0.5;
-		} else t.prev_sample_e = input_l; // for this, need previousSampleC always
-		if (slew > 0.0) slew = 1.0 + (sqrt(slew) * 0.5);
-		else slew = 1.0 - (sqrt(-slew) * 0.5);
-		input_l -= input_l * fabs(input_l) * slew * gainscaling;
-		// reusing gainscaling that's part of another algorithm
-		if (input_l > 0.52) input_l = 0.52;
-		if (input_l < -0.52) input_l = -0.52;
-		input_l *= 1.923076923076923;
-		// hysteresis and spiky fuzz R
-		slew = t.prev_sample_f - input_r;
-		if (overallscale > 1.9) {
-			double stored = input_r;
-			input_r += t.prev_sample_f;
-			t.prev_sample_f = stored;
-			input_r *= 0.5;
-		} else t.prev_sample_f = input_r; // for this, need previousSampleC always
-		if (slew > 0.0) slew = 1.0 + (sqrt(slew) * 0.5);
-		else slew = 1.0 - (sqrt(-slew) * 0.5);
-		input_r -= input_r * fabs(input_r) * slew * gainscaling;
-		// reusing gainscaling that's part of another algorithm
-		if (input_r > 0.52) input_r = 0.52;
-		if (input_r < -0.52) input_r = -0.52;
-		input_r *= 1.923076923076923;
-		// end hysteresis and spiky fuzz section
-
-		// begin 64 bit stereo floating point dither
-		// int expon; frexp((double)inputSampleL, &expon);
-		t.fdp_l ^= t.fdp_l << 13;
-		t.fdp_l ^= t.fdp_l >> 17;
-		t.fdp_l ^= t.fdp_l << 5;
-		// inputSampleL += ((double(fpdL)-uint32_t(0x7fffffff)) * 1.1e-44l *
-		// pow(2,expon+62)); frexp((double)inputSampleR, &expon);
-		t.fdp_r ^= t.fdp_r << 13;
-		t.fdp_r ^= t.fdp_r >> 17;
-		t.fdp_r ^= t.fdp_r << 5;
-		// inputSampleR += ((double(fpdR)-uint32_t(0x7fffffff)) * 1.1e-44l *
-		// pow(2,expon+62)); end 64 bit stereo floating point dither
-
-		*out1 = input_l;
-		*out2 = input_r;
-
-		in1++;
-		in2++;
-		out1++;
-		out2++;
+	if (t.adaa) {
+		if (t.adaa_powerfactor != powerfactor) tube_select_adaa_table(t, powerfactor);
+		tube_dispatch<true>(t, powerfactor, inputs, outputs, sampleframes);
+	} else {
+		tube_dispatch<false>(t, powerfactor, inputs, outputs, sampleframes);
 	}
 }
 } // namespace trnr
@@ -1,5 +1,5 @@
 /*
- * fold.h
+ * alaw.h
  * Copyright (c) 2025 Christopher Herb
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
@@ -23,11 +23,33 @@
 
 #pragma once
 
+#include "../util/audio_math.h"
+#include <array>
 #include <cmath>
+#include <stdint.h>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRNR_COMPANDING_SSE2
+#endif
 
 namespace trnr {
 
 constexpr float A_LAW_A = 87.6f;
+constexpr float A_LAW_INV_A = 1.f / A_LAW_A;
+// 1 + ln(A), std::log is not constexpr
+constexpr float A_LAW_LOG_A1 = 5.472780997942346f;
+constexpr float A_LAW_INV_LOG_A1 = 1.f / A_LAW_LOG_A1;
+
+constexpr float MU_LAW_MU = 255.f;
+constexpr float MU_LAW_INV_MU = 1.f / MU_LAW_MU;
+// log2(1 + mu), exact for mu = 255
+constexpr float MU_LAW_LOG2_MU1 = 8.f;
+constexpr float MU_LAW_INV_LOG2_MU1 = 1.f / MU_LAW_LOG2_MU1;
+
+constexpr float COMPANDING_LN2 = 0.693147181f;
+constexpr float COMPANDING_LOG2E = 1.44269504f;
 
 inline float alaw_encode(float input)
 {
@@ -35,11 +57,10 @@ inline float alaw_encode(float input)
 	float abs_sample = std::fabs(input);
 
 	float output;
-	if (abs_sample < (1.0f / A_LAW_A)) {
-		output = sign * (A_LAW_A * abs_sample) / (1.0f + std::log(A_LAW_A));
+	if (abs_sample < A_LAW_INV_A) {
+		output = sign * (A_LAW_A * abs_sample) * A_LAW_INV_LOG_A1;
 	} else {
-		output =
-			sign * (1.0f + std::log(A_LAW_A * abs_sample)) / (1.0f + std::log(A_LAW_A));
+		output = sign * (1.0f + std::log(A_LAW_A * abs_sample)) * A_LAW_INV_LOG_A1;
 	}
 
 	return output;
@@ -51,12 +72,365 @@ inline float alaw_decode(float input)
 	float abs_comp = std::fabs(input);
 
 	float sample;
-	if (abs_comp < (1.0f / (1.0f + std::log(A_LAW_A)))) {
-		sample = sign * (abs_comp * (1.0f + std::log(A_LAW_A))) / A_LAW_A;
+	if (abs_comp < A_LAW_INV_LOG_A1) {
+		sample = sign * (abs_comp * A_LAW_LOG_A1) * A_LAW_INV_A;
 	} else {
-		sample = sign * std::exp(abs_comp * (1.0f + std::log(A_LAW_A)) - 1.0f) / A_LAW_A;
+		sample = sign * std::exp(abs_comp * A_LAW_LOG_A1 - 1.0f) * A_LAW_INV_A;
 	}
 
 	return sample;
 }
+
+inline float mulaw_encode(float input)
+{
+	float sign = (input >= 0.0f) ? 1.0f : -1.0f;
+	float abs_sample = std::fabs(input);
+	return sign * std::log2(1.0f + MU_LAW_MU * abs_sample) * MU_LAW_INV_LOG2_MU1;
+}
+
+inline float mulaw_decode(float input)
+{
+	float sign = (input >= 0.0f) ? 1.0f : -1.0f;
+	float abs_comp = std::fabs(input);
+	return sign * (std::exp2(abs_comp * MU_LAW_LOG2_MU1) - 1.0f) * MU_LAW_INV_MU;
+}
+
+// the same curves on fast_log2/fast_exp2, used by the block functions. encoders are off
+// by at most ~2.3e-6, decoders by a relative ~4.2e-6.
+
+inline float fast_alaw_encode(float input)
+{
+	float abs_sample = std::fabs(input);
+	float output = abs_sample * (A_LAW_A * A_LAW_INV_LOG_A1);
+	if (abs_sample >= A_LAW_INV_A) {
+		float log = fast_log2(A_LAW_A * abs_sample);
+		output = log * (COMPANDING_LN2 * A_LAW_INV_LOG_A1) + A_LAW_INV_LOG_A1;
+	}
+	return std::copysign(output, input);
+}
+
+inline float fast_alaw_decode(float input)
+{
+	float abs_comp = std::fabs(input);
+	float sample = abs_comp * (A_LAW_LOG_A1 * A_LAW_INV_A);
+	if (abs_comp >= A_LAW_INV_LOG_A1) {
+		float exponent = abs_comp * (A_LAW_LOG_A1 * COMPANDING_LOG2E) - COMPANDING_LOG2E;
+		sample = fast_exp2(exponent) * A_LAW_INV_A;
+	}
+	return std::copysign(sample, input);
+}
+
+inline float fast_mulaw_encode(float input)
+{
+	float output = fast_log2(1.0f + MU_LAW_MU * std::fabs(input)) * MU_LAW_INV_LOG2_MU1;
+	return std::copysign(output, input);
+}
+
+inline float fast_mulaw_decode(float input)
+{
+	float sample = (fast_exp2(std::fabs(input) * MU_LAW_LOG2_MU1) - 1.0f) * MU_LAW_INV_MU;
+	return std::copysign(sample, input);
+}
+
+#ifdef TRNR_COMPANDING_SSE2
+// four lanes of fast_log2
+inline __m128 fast_log2_sse2(__m128 x)
+{
+	__m128i bits = _mm_castps_si128(x);
+	__m128i biased = _mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff));
+	__m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(biased, _mm_set1_epi32(127)));
+	__m128i mantissa = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+									_mm_set1_epi32(0x3f800000));
+	__m128 m = _mm_sub_ps(_mm_castsi128_ps(mantissa), _mm_set1_ps(1.f));
+
+	__m128 p = _mm_set1_ps(0.0439290999f);
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-0.189834429f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(0.411564149f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-0.707254899f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.44159239f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.43724989e-05f));
+	return _mm_add_ps(exponent, p);
+}
+
+// four lanes of fast_exp2
+inline __m128 fast_exp2_sse2(__m128 x)
+{
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.f)), _mm_set1_ps(127.f));
+
+	// floor, truncation rounds negative values up
+	__m128i truncated = _mm_cvttps_epi32(x);
+	__m128i above = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), x));
+	__m128i whole = _mm_add_epi32(truncated, above);
+	__m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(whole));
+
+	__m128 p = _mm_set1_ps(0.0136839897f);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.051717781f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.241621243f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.692969586f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.00000359f));
+
+	__m128i scale = _mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23);
+	return _mm_mul_ps(p, _mm_castsi128_ps(scale));
+}
+
+// four lanes of fast_alaw_encode
+inline __m128 alaw_encode_sse2(__m128 x)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	__m128 magnitude = _mm_and_ps(x, abs_mask);
+	__m128 linear = _mm_mul_ps(magnitude, _mm_set1_ps(A_LAW_A * A_LAW_INV_LOG_A1));
+	__m128 log = fast_log2_sse2(_mm_mul_ps(magnitude, _mm_set1_ps(A_LAW_A)));
+	log = _mm_mul_ps(log, _mm_set1_ps(COMPANDING_LN2 * A_LAW_INV_LOG_A1));
+	log = _mm_add_ps(log, _mm_set1_ps(A_LAW_INV_LOG_A1));
+
+	__m128 small = _mm_cmplt_ps(magnitude, _mm_set1_ps(A_LAW_INV_A));
+	__m128 output = _mm_or_ps(_mm_and_ps(small, linear), _mm_andnot_ps(small, log));
+	return _mm_or_ps(output, _mm_andnot_ps(abs_mask, x));
+}
+
+// four lanes of fast_alaw_decode
+inline __m128 alaw_decode_sse2(__m128 x)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 log2e = _mm_set1_ps(COMPANDING_LOG2E);
+
+	__m128 magnitude = _mm_and_ps(x, abs_mask);
+	__m128 linear = _mm_mul_ps(magnitude, _mm_set1_ps(A_LAW_LOG_A1 * A_LAW_INV_A));
+	__m128 scaled = _mm_mul_ps(magnitude, _mm_set1_ps(A_LAW_LOG_A1 * COMPANDING_LOG2E));
+	__m128 exponent = _mm_sub_ps(scaled, log2e);
+	__m128 exp = _mm_mul_ps(fast_exp2_sse2(exponent), _mm_set1_ps(A_LAW_INV_A));
+
+	__m128 small = _mm_cmplt_ps(magnitude, _mm_set1_ps(A_LAW_INV_LOG_A1));
+	__m128 sample = _mm_or_ps(_mm_and_ps(small, linear), _mm_andnot_ps(small, exp));
+	return _mm_or_ps(sample, _mm_andnot_ps(abs_mask, x));
+}
+
+// four lanes of fast_mulaw_encode
+inline __m128 mulaw_encode_sse2(__m128 x)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	__m128 magnitude = _mm_and_ps(x, abs_mask);
+	__m128 expanded = _mm_mul_ps(_mm_set1_ps(MU_LAW_MU), magnitude);
+	expanded = _mm_add_ps(_mm_set1_ps(1.f), expanded);
+	__m128 log = fast_log2_sse2(expanded);
+	__m128 output = _mm_mul_ps(log, _mm_set1_ps(MU_LAW_INV_LOG2_MU1));
+	return _mm_or_ps(output, _mm_andnot_ps(abs_mask, x));
+}
+
+// four lanes of fast_mulaw_decode
+inline __m128 mulaw_decode_sse2(__m128 x)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	__m128 magnitude = _mm_and_ps(x, abs_mask);
+	__m128 exp = fast_exp2_sse2(_mm_mul_ps(magnitude, _mm_set1_ps(MU_LAW_LOG2_MU1)));
+	exp = _mm_sub_ps(exp, _mm_set1_ps(1.f));
+	__m128 sample = _mm_mul_ps(exp, _mm_set1_ps(MU_LAW_INV_MU));
+	return _mm_or_ps(sample, _mm_andnot_ps(abs_mask, x));
+}
+#endif
+
+// branch free, four samples at a time for float buffers on sse2
+template <typename t_sample>
+inline void alaw_encode_block(t_sample* audio, int frames)
+{
+	int i = 0;
+#ifdef TRNR_COMPANDING_SSE2
+	if constexpr (std::is_same<t_sample, float>::value) {
+		for (; i + 4 <= frames; i += 4)
+			_mm_storeu_ps(audio + i, alaw_encode_sse2(_mm_loadu_ps(audio + i)));
+	}
+#endif
+	for (; i < frames; i++) audio[i] = fast_alaw_encode((float)audio[i]);
+}
+
+template <typename t_sample>
+inline void alaw_decode_block(t_sample* audio, int frames)
+{
+	int i = 0;
+#ifdef TRNR_COMPANDING_SSE2
+	if constexpr (std::is_same<t_sample, float>::value) {
+		for (; i + 4 <= frames; i += 4)
+			_mm_storeu_ps(audio + i, alaw_decode_sse2(_mm_loadu_ps(audio + i)));
+	}
+#endif
+	for (; i < frames; i++) audio[i] = fast_alaw_decode((float)audio[i]);
+}
+
+template <typename t_sample>
+inline void mulaw_encode_block(t_sample* audio, int frames)
+{
+	int i = 0;
+#ifdef TRNR_COMPANDING_SSE2
+	if constexpr (std::is_same<t_sample, float>::value) {
+		for (; i + 4 <= frames; i += 4)
+			_mm_storeu_ps(audio + i, mulaw_encode_sse2(_mm_loadu_ps(audio + i)));
+	}
+#endif
+	for (; i < frames; i++) audio[i] = fast_mulaw_encode((float)audio[i]);
+}
+
+template <typename t_sample>
+inline void mulaw_decode_block(t_sample* audio, int frames)
+{
+	int i = 0;
+#ifdef TRNR_COMPANDING_SSE2
+	if constexpr (std::is_same<t_sample, float>::value) {
+		for (; i + 4 <= frames; i += 4)
+			_mm_storeu_ps(audio + i, mulaw_decode_sse2(_mm_loadu_ps(audio + i)));
+	}
+#endif
+	for (; i < frames; i++) audio[i] = fast_mulaw_decode((float)audio[i]);
+}
+
+///////////
+// G.711 //
+///////////
+
+// 8 bit A-law and mu-law as used in telephony, bit exact to the reference implementation
+// by Sun Microsystems (g711.c). 16 bit linear pcm, A-law uses the upper 13 bits, mu-law
+// the upper 14 bits.
+
+constexpr int G711_ALAW_TABLE_SIZE = 1 << 13;
+constexpr int G711_MULAW_TABLE_SIZE = 1 << 14;
+constexpr int G711_MULAW_BIAS = 0x84;
+constexpr int G711_MULAW_CLIP = 8159;
+
+// index of the segment value is in, 8 if it is beyond the last segment. segments double
+// in size, starting at first_size.
+inline int g711_segment(int value, int first_size)
+{
+	int segment = 0;
+	while (segment < 8 && value >= (first_size << segment)) segment++;
+	return segment;
+}
+
+inline uint8_t g711_linear_to_alaw(int16_t pcm)
+{
+	int value = pcm >> 3;
+	int mask = 0xd5;
+	if (value < 0) {
+		mask = 0x55;
+		value = -value - 1;
+	}
+
+	int segment = g711_segment(value, 0x20);
+	if (segment >= 8) return 0x7f ^ mask;
+
+	int alaw = segment << 4;
+	alaw |= (value >> (segment < 2 ? 1 : segment)) & 0xf;
+	return alaw ^ mask;
+}
+
+inline int16_t g711_alaw_to_linear(uint8_t alaw)
+{
+	alaw ^= 0x55;
+	int value = (alaw & 0xf) << 4;
+	int segment = (alaw & 0x70) >> 4;
+
+	if (segment == 0) value += 8;
+	else {
+		value += 0x108;
+		if (segment > 1) value <<= segment - 1;
+	}
+	return (alaw & 0x80) ? value : -value;
+}
+
+inline uint8_t g711_linear_to_mulaw(int16_t pcm)
+{
+	int value = pcm >> 2;
+	int mask = 0xff;
+	if (value < 0) {
+		mask = 0x7f;
+		value = -value;
+	}
+	if (value > G711_MULAW_CLIP) value = G711_MULAW_CLIP;
+	value += G711_MULAW_BIAS >> 2;
+
+	int segment = g711_segment(value, 0x40);
+	if (segment >= 8) return 0x7f ^ mask;
+
+	int mulaw = (segment << 4) | ((value >> (segment + 1)) & 0xf);
+	return mulaw ^ mask;
+}
+
+inline int16_t g711_mulaw_to_linear(uint8_t mulaw)
+{
+	mulaw = ~mulaw;
+	int value = ((mulaw & 0xf) << 3) + G711_MULAW_BIAS;
+	value <<= (mulaw & 0x70) >> 4;
+	return (mulaw & 0x80) ? (G711_MULAW_BIAS - value) : (value - G711_MULAW_BIAS);
+}
+
+// lookup tables for the codec, about 25 kB, build once with g711_init and share
+struct g711_tables {
+	std::array<uint8_t, G711_ALAW_TABLE_SIZE> alaw_encode;
+	std::array<uint8_t, G711_MULAW_TABLE_SIZE> mulaw_encode;
+	std::array<int16_t, 256> alaw_decode;
+	std::array<int16_t, 256> mulaw_decode;
+};
+
+inline void g711_init(g711_tables& t)
+{
+	// the encoders only look at the upper bits, so one entry per truncated value
+	for (int i = 0; i < G711_ALAW_TABLE_SIZE; i++) {
+		int16_t pcm = (int16_t)((i - G711_ALAW_TABLE_SIZE / 2) * 8);
+		t.alaw_encode[(pcm >> 3) & (G711_ALAW_TABLE_SIZE - 1)] = g711_linear_to_alaw(pcm);
+	}
+	for (int i = 0; i < G711_MULAW_TABLE_SIZE; i++) {
+		int16_t pcm = (int16_t)((i - G711_MULAW_TABLE_SIZE / 2) * 4);
+		int index = (pcm >> 2) & (G711_MULAW_TABLE_SIZE - 1);
+		t.mulaw_encode[index] = g711_linear_to_mulaw(pcm);
+	}
+	for (int i = 0; i < 256; i++) {
+		t.alaw_decode[i] = g711_alaw_to_linear((uint8_t)i);
+		t.mulaw_decode[i] = g711_mulaw_to_linear((uint8_t)i);
+	}
+}
+
+inline uint8_t g711_alaw_encode(const g711_tables& t, int16_t pcm)
+{
+	return t.alaw_encode[(pcm >> 3) & (G711_ALAW_TABLE_SIZE - 1)];
+}
+
+inline int16_t g711_alaw_decode(const g711_tables& t, uint8_t alaw)
+{
+	return t.alaw_decode[alaw];
+}
+
+inline uint8_t g711_mulaw_encode(const g711_tables& t, int16_t pcm)
+{
+	return t.mulaw_encode[(pcm >> 2) & (G711_MULAW_TABLE_SIZE - 1)];
+}
+
+inline int16_t g711_mulaw_decode(const g711_tables& t, uint8_t mulaw)
+{
+	return t.mulaw_decode[mulaw];
+}
+
+inline void g711_alaw_encode_block(const g711_tables& t, const int16_t* input,
+								   uint8_t* output, int frames)
+{
+	for (int i = 0; i < frames; i++) output[i] = g711_alaw_encode(t, input[i]);
+}
+
+inline void g711_alaw_decode_block(const g711_tables& t, const uint8_t* input,
+								   int16_t* output, int frames)
+{
+	for (int i = 0; i < frames; i++) output[i] = g711_alaw_decode(t, input[i]);
+}
+
+inline void g711_mulaw_encode_block(const g711_tables& t, const int16_t* input,
+									uint8_t* output, int frames)
+{
+	for (int i = 0; i < frames; i++) output[i] = g711_mulaw_encode(t, input[i]);
+}
+
+inline void g711_mulaw_decode_block(const g711_tables& t, const uint8_t* input,
+									int16_t* output, int frames)
+{
+	for (int i = 0; i < frames; i++) output[i] = g711_mulaw_decode(t, input[i]);
+}
 } // namespace trnr
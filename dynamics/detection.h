@@ -0,0 +1,58 @@
+/*
+ * detection.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace trnr {
+
+// how the channels of a multichannel signal drive the gain computer
+enum detection_mode {
+	DETECT_MEAN,	// mean of all channels (mono sum)
+	DETECT_MAX,		// loudest channel
+	DETECT_RMS,		// root mean square across channels
+	DETECT_UNLINKED // every channel has its own detector and gain
+};
+
+// combines one frame of channel values to a single, rectified detector input
+template <size_t channels>
+inline float detection_link(detection_mode mode, const float* frame)
+{
+	float link = 0.f;
+
+	switch (mode) {
+	case DETECT_MEAN:
+		for (size_t ch = 0; ch < channels; ++ch) link += frame[ch];
+		return std::fabs(link / channels);
+	case DETECT_MAX:
+		for (size_t ch = 0; ch < channels; ++ch) link = fmaxf(link, std::fabs(frame[ch]));
+		return link;
+	case DETECT_RMS:
+	default:
+		for (size_t ch = 0; ch < channels; ++ch) link += frame[ch] * frame[ch];
+		return sqrtf(link / channels);
+	}
+}
+} // namespace trnr
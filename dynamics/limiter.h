@@ -0,0 +1,240 @@
+/*
+ * limiter.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../util/audio_math.h"
+#include "../util/param_queue.h"
+#include "meter.h"
+#include "window_detector.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace trnr {
+
+// number of frames the gain is computed for before it is applied to the audio
+constexpr int LIMITER_CHUNK_SIZE = 64;
+
+// Lookahead brickwall limiter. The audio is delayed by the lookahead, the gain needed
+// to keep every sample below the ceiling is held over lookahead + 1 samples with a
+// sliding minimum, released with a one-pole and then averaged over the lookahead.
+// The average only contains values at or below the held gain, so the delayed output
+// never exceeds the ceiling (up to float rounding). Channels are always linked.
+template <size_t channels>
+struct limiter_n {
+	double samplerate;
+	float ceiling_db = -0.3f;
+	float lookahead_ms = 1.5f;
+	float release_ms = 50.f;
+
+	int lookahead = 1; // samples, equals the latency
+	float ceiling_lin = 1.f;
+	float release_coef = 0.f;
+
+	// sliding maximum of the linked input over lookahead + 1 samples
+	window_peak hold;
+
+	// gain envelope after the release, averaged over the last lookahead samples
+	float envelope = 1.f;
+	std::vector<float> ramp;
+	double ramp_sum = 0.0;
+	int ramp_pos = 0;
+
+	// delay line, one ring of lookahead samples per channel
+	std::vector<float> delay;
+	int delay_pos = 0;
+
+	// gain reduction and levels of the last block for the ui, see dynamics_meter_read
+	dynamics_meter meter;
+};
+
+using limiter = limiter_n<2>;
+
+enum limiter_param { LIMITER_CEILING, LIMITER_RELEASE };
+
+template <size_t channels>
+inline void limiter_set_param(limiter_n<channels>& l, limiter_param param, float value)
+{
+	switch (param) {
+	case LIMITER_CEILING:
+		l.ceiling_db = value;
+		l.ceiling_lin = db_2_lin(l.ceiling_db);
+		break;
+	case LIMITER_RELEASE:
+		l.release_ms = value;
+		l.release_coef = exp(-1000.0 / (l.release_ms * l.samplerate));
+		break;
+	default:
+		break;
+	}
+}
+
+template <size_t channels>
+inline float limiter_get_param(const limiter_n<channels>& l, limiter_param param)
+{
+	switch (param) {
+	case LIMITER_CEILING:
+		return l.ceiling_db;
+	case LIMITER_RELEASE:
+		return l.release_ms;
+	default:
+		return -1.f;
+	}
+}
+
+// allocates the delay line for lookahead_ms, not realtime safe
+template <size_t channels>
+inline void limiter_init(limiter_n<channels>& l, double samplerate)
+{
+	l.samplerate = samplerate;
+	l.lookahead =
+		std::max(1, (int)std::lround(ms_to_samples(l.lookahead_ms, samplerate)));
+
+	window_peak_init(l.hold, 1, l.lookahead + 1);
+
+	l.envelope = 1.f;
+	l.ramp.assign(l.lookahead, 1.f);
+	l.ramp_sum = l.lookahead;
+	l.ramp_pos = 0;
+
+	l.delay.assign(channels * l.lookahead, 0.f);
+	l.delay_pos = 0;
+
+	limiter_set_param(l, LIMITER_CEILING, l.ceiling_db);
+	limiter_set_param(l, LIMITER_RELEASE, l.release_ms);
+}
+
+// latency in samples the host has to compensate
+template <size_t channels>
+inline int limiter_latency(const limiter_n<channels>& l)
+{
+	return l.lookahead;
+}
+
+// limiter_process_block without publishing the meter, the levels are added to
+// meter_block
+template <typename sample, size_t channels>
+inline void limiter_process_frames(limiter_n<channels>& l, sample** audio, int frames,
+								   dynamics_meter_block& meter_block)
+{
+	const int lookahead = l.lookahead;
+	const float ceiling = l.ceiling_lin;
+	const float release_coef = l.release_coef;
+	const double ramp_norm = 1.0 / lookahead;
+
+	float gain[LIMITER_CHUNK_SIZE];
+
+	for (int offset = 0; offset < frames; offset += LIMITER_CHUNK_SIZE) {
+		int len = std::min(LIMITER_CHUNK_SIZE, frames - offset);
+
+		// linked peak detection, once per frame
+		float link[LIMITER_CHUNK_SIZE];
+		for (int i = 0; i < len; i++) link[i] = 0.f;
+		for (size_t ch = 0; ch < channels; ch++) {
+			const sample* channel = audio[ch] + offset;
+			for (int i = 0; i < len; i++)
+				link[i] = std::max(link[i], std::fabs((float)channel[i]));
+		}
+		for (int i = 0; i < len; i++)
+			meter_block.input_peak = std::max(meter_block.input_peak, link[i]);
+
+		// gain computer
+		uint64_t time = l.hold.time;
+		float envelope = l.envelope;
+		double ramp_sum = l.ramp_sum;
+		int ramp_pos = l.ramp_pos;
+
+		for (int i = 0; i < len; i++) {
+			float peak = window_peak_push(l.hold, 0, link[i], time++);
+			float target = peak > ceiling ? ceiling / peak : 1.f;
+
+			// attack is instant, the averaging below turns it into a ramp
+			if (target < envelope) envelope = target;
+			else envelope = target + release_coef * (envelope - target);
+
+			ramp_sum += (double)envelope - l.ramp[ramp_pos];
+			l.ramp[ramp_pos] = envelope;
+			if (++ramp_pos == lookahead) ramp_pos = 0;
+
+			gain[i] = (float)(ramp_sum * ramp_norm);
+		}
+
+		l.hold.time = time;
+		l.envelope = envelope;
+		l.ramp_sum = ramp_sum;
+		l.ramp_pos = ramp_pos;
+
+		dynamics_meter_add_gain(meter_block, gain, len);
+
+		// delay and apply gain
+		int delay_pos = l.delay_pos;
+		for (size_t ch = 0; ch < channels; ch++) {
+			float* ring = l.delay.data() + ch * lookahead;
+			sample* channel = audio[ch] + offset;
+			delay_pos = l.delay_pos;
+
+			for (int i = 0; i < len; i++) {
+				float delayed = ring[delay_pos];
+				ring[delay_pos] = (float)channel[i];
+				if (++delay_pos == lookahead) delay_pos = 0;
+				channel[i] = delayed * gain[i];
+			}
+			meter_block.output_peak =
+				dynamics_meter_peak(channel, len, meter_block.output_peak);
+		}
+		l.delay_pos = delay_pos;
+	}
+}
+
+template <typename sample, size_t channels>
+inline void limiter_process_block(limiter_n<channels>& l, sample** audio, int frames)
+{
+	dynamics_meter_block meter_block;
+	limiter_process_frames(l, audio, frames, meter_block);
+	dynamics_meter_publish(l.meter, meter_block);
+}
+
+// limiter_process_block with sample accurate automation, the event params are
+// limiter_param. A new ceiling ramps in over the lookahead like any gain change. The
+// meter is published once for the whole block.
+template <typename sample, size_t channels>
+inline void limiter_process_block_events(limiter_n<channels>& l, sample** audio,
+										 int frames, param_queue& q)
+{
+	auto view = audio_buffer_view_of<channels>(audio, frames);
+	dynamics_meter_block meter_block;
+
+	param_queue_render(
+		q, frames,
+		[&](int offset, int len) {
+			auto sub = audio_buffer_view_frames(view, offset, len);
+			limiter_process_frames(l, sub.channel_ptrs, len, meter_block);
+		},
+		[&](int param, float value) {
+			limiter_set_param(l, (limiter_param)param, value);
+		});
+
+	dynamics_meter_publish(l.meter, meter_block);
+}
+} // namespace trnr
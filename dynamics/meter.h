@@ -0,0 +1,143 @@
+/*
+ * meter.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../util/audio_math.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace trnr {
+
+// per block values of a dynamics module, gain reduction is positive dB
+struct dynamics_meter_values {
+	float gain_reduction_max_db = 0.f;
+	float gain_reduction_min_db = 0.f;
+	float input_db = -400.f;
+	float output_db = -400.f;
+	uint32_t block = 0; // number of published blocks
+};
+
+// accumulates the linear values while a block is processed
+struct dynamics_meter_block {
+	float gain_min = 1.f;
+	float gain_max = 0.f;
+	float input_peak = 0.f;
+	float output_peak = 0.f;
+};
+
+inline void dynamics_meter_add_gain(dynamics_meter_block& b, const float* gain,
+									int frames)
+{
+	float gain_min = b.gain_min;
+	float gain_max = b.gain_max;
+	for (int i = 0; i < frames; ++i) {
+		gain_min = gain[i] < gain_min ? gain[i] : gain_min;
+		gain_max = gain[i] > gain_max ? gain[i] : gain_max;
+	}
+	b.gain_min = gain_min;
+	b.gain_max = gain_max;
+}
+
+template <typename sample>
+inline float dynamics_meter_peak(const sample* audio, int frames, float peak)
+{
+	for (int i = 0; i < frames; ++i) {
+		float value = std::fabs((float)audio[i]);
+		peak = value > peak ? value : peak;
+	}
+	return peak;
+}
+
+// Seqlock snapshot of the latest block. The audio thread publishes without waiting,
+// the ui thread reads without blocking the audio thread.
+struct dynamics_meter {
+	std::atomic<uint32_t> sequence {0};
+	std::atomic<float> gain_reduction_max_db {0.f};
+	std::atomic<float> gain_reduction_min_db {0.f};
+	std::atomic<float> input_db {-400.f};
+	std::atomic<float> output_db {-400.f};
+
+	dynamics_meter() = default;
+
+	// copies the current values so modules holding a meter stay copyable
+	dynamics_meter(const dynamics_meter& other) { *this = other; }
+
+	dynamics_meter& operator=(const dynamics_meter& other)
+	{
+		const auto relaxed = std::memory_order_relaxed;
+		sequence.store(other.sequence.load(relaxed) & ~1u, relaxed);
+		gain_reduction_max_db.store(other.gain_reduction_max_db.load(relaxed), relaxed);
+		gain_reduction_min_db.store(other.gain_reduction_min_db.load(relaxed), relaxed);
+		input_db.store(other.input_db.load(relaxed), relaxed);
+		output_db.store(other.output_db.load(relaxed), relaxed);
+		return *this;
+	}
+};
+
+// audio thread, call once at the end of every block
+inline void dynamics_meter_publish(dynamics_meter& m, const dynamics_meter_block& b)
+{
+	const auto relaxed = std::memory_order_relaxed;
+	uint32_t sequence = m.sequence.load(relaxed);
+
+	m.sequence.store(sequence + 1, relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	m.gain_reduction_max_db.store(-lin_2_db(std::max(b.gain_min, 0.f)), relaxed);
+	m.gain_reduction_min_db.store(-lin_2_db(std::max(b.gain_max, b.gain_min)), relaxed);
+	m.input_db.store(lin_2_db(b.input_peak), relaxed);
+	m.output_db.store(lin_2_db(b.output_peak), relaxed);
+
+	m.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Any thread. Returns false if the audio thread was publishing during every attempt,
+// `v` is left untouched then and the caller just tries again on its next poll.
+inline bool dynamics_meter_read(const dynamics_meter& m, dynamics_meter_values& v,
+								int attempts = 8)
+{
+	const auto relaxed = std::memory_order_relaxed;
+
+	for (int i = 0; i < attempts; ++i) {
+		uint32_t before = m.sequence.load(std::memory_order_acquire);
+		if (before & 1u) continue;
+
+		dynamics_meter_values read;
+		read.gain_reduction_max_db = m.gain_reduction_max_db.load(relaxed);
+		read.gain_reduction_min_db = m.gain_reduction_min_db.load(relaxed);
+		read.input_db = m.input_db.load(relaxed);
+		read.output_db = m.output_db.load(relaxed);
+		read.block = before / 2;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m.sequence.load(relaxed) == before) {
+			v = read;
+			return true;
+		}
+	}
+	return false;
+}
+} // namespace trnr
@@ -0,0 +1,359 @@
+/*
+ * multiband.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../filter/spliteq.h"
+#include "../util/audio_math.h"
+#include "../util/param_queue.h"
+#include "../util/smoother.h"
+#include "detection.h"
+#include "meter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace trnr {
+
+// number of frames that are split and compressed before the bands are summed
+constexpr int MULTIBAND_CHUNK_SIZE = 64;
+// time the makeup gain of a band takes to follow a multiband_set_param
+constexpr float MULTIBAND_MAKEUP_RAMP_MS = 20.f;
+
+enum multiband_band_index {
+	MULTIBAND_LOW,
+	MULTIBAND_MID,
+	MULTIBAND_HIGH,
+	MULTIBAND_BANDS
+};
+
+// feed-forward compressor of one band
+struct multiband_band {
+	float threshold_db = 0.f;
+	float ratio = 4.f;
+	float attack_ms = 5.f;
+	float release_ms = 100.f;
+	float makeup = 0.f;
+
+	float envelope_db = 0.f;
+	float attack_coef = 0.f;
+	float release_coef = 0.f;
+	float makeup_lin = 1.f;
+
+	// ramp of makeup_lin after multiband_set_param
+	bool makeup_ramping = false;
+	smoother makeup_smoother;
+
+	// gain reduction and levels of the band for the ui, see dynamics_meter_read
+	dynamics_meter meter;
+};
+
+// Three band compressor. The input is split once with the same Linkwitz-Riley
+// butterworth cascades as spliteq (low: lp x2, mid: hp x2 + lp x2, high: hp x2), every
+// band runs its own gain computer and the bands are summed back in place.
+template <size_t channels>
+struct multiband_n {
+	double samplerate;
+	double low_mid_crossover = 150.0;	// Hz
+	double mid_high_crossover = 1700.0; // Hz
+	detection_mode detection = DETECT_MAX; // bands are always linked
+
+	multiband_band bands[MULTIBAND_BANDS];
+
+	// crossover filters per channel
+	butterworth low_lp[channels][2];
+	butterworth mid_hp[channels][2];
+	butterworth mid_lp[channels][2];
+	butterworth high_hp[channels][2];
+};
+
+using multiband = multiband_n<2>;
+
+// params of a band for multiband_set_param
+enum multiband_param {
+	MULTIBAND_THRESHOLD,
+	MULTIBAND_RATIO,
+	MULTIBAND_ATTACK,
+	MULTIBAND_RELEASE,
+	MULTIBAND_MAKEUP,
+	MULTIBAND_BAND_PARAMS
+};
+
+// event params of multiband_process_block_events: the params of every band (see
+// multiband_event_param), then the two crossovers
+constexpr int MULTIBAND_LOW_MID_CROSSOVER = MULTIBAND_BANDS * MULTIBAND_BAND_PARAMS;
+constexpr int MULTIBAND_MID_HIGH_CROSSOVER = MULTIBAND_LOW_MID_CROSSOVER + 1;
+
+inline int multiband_event_param(multiband_band_index index, multiband_param param)
+{
+	return index * MULTIBAND_BAND_PARAMS + param;
+}
+
+inline void multiband_filter_setup(butterworth& b, filter_type type, double cutoff,
+								   double samplerate)
+{
+	b.type = type;
+	b.cutoff = cutoff;
+	butterworth_biquad_coeffs(b, samplerate);
+}
+
+// Updates the crossover frequencies. They follow spliteq's convention: the values are
+// nominal band edges and the filters run at spliteq_crossover_cutoff() of them, so a
+// multiband and a spliteq set to the same numbers split at the same place. Keeps the
+// filter state, so it can be called while the audio is running.
+template <size_t channels>
+inline void multiband_set_crossovers(multiband_n<channels>& mb, double low_mid_crossover,
+									 double mid_high_crossover)
+{
+	mb.low_mid_crossover = low_mid_crossover;
+	mb.mid_high_crossover = mid_high_crossover;
+
+	double low_mid_cutoff = spliteq_crossover_cutoff(low_mid_crossover);
+	double mid_high_cutoff = spliteq_crossover_cutoff(mid_high_crossover);
+
+	for (size_t ch = 0; ch < channels; ++ch) {
+		for (int s = 0; s < 2; ++s) {
+			multiband_filter_setup(mb.low_lp[ch][s], LOWPASS, low_mid_cutoff,
+								   mb.samplerate);
+			multiband_filter_setup(mb.mid_hp[ch][s], HIGHPASS, low_mid_cutoff,
+								   mb.samplerate);
+			multiband_filter_setup(mb.mid_lp[ch][s], LOWPASS, mid_high_cutoff,
+								   mb.samplerate);
+			multiband_filter_setup(mb.high_hp[ch][s], HIGHPASS, mid_high_cutoff,
+								   mb.samplerate);
+		}
+	}
+}
+
+// recalculates the coefficients after the params of a band changed
+template <size_t channels>
+inline void multiband_update_band(multiband_n<channels>& mb, multiband_band_index index)
+{
+	multiband_band& b = mb.bands[index];
+	b.attack_coef = exp(-1000.0 / (b.attack_ms * mb.samplerate));
+	b.release_coef = exp(-1000.0 / (b.release_ms * mb.samplerate));
+	b.makeup_lin = db_2_lin(b.makeup);
+	b.makeup_ramping = false;
+}
+
+// changes one param of a band, the makeup gain ramps over MULTIBAND_MAKEUP_RAMP_MS
+template <size_t channels>
+inline void multiband_set_param(multiband_n<channels>& mb, multiband_band_index index,
+								multiband_param param, float value)
+{
+	multiband_band& b = mb.bands[index];
+
+	switch (param) {
+	case MULTIBAND_THRESHOLD:
+		b.threshold_db = value;
+		break;
+	case MULTIBAND_RATIO:
+		b.ratio = value;
+		break;
+	case MULTIBAND_ATTACK:
+		b.attack_ms = value;
+		b.attack_coef = exp(-1000.0 / (b.attack_ms * mb.samplerate));
+		break;
+	case MULTIBAND_RELEASE:
+		b.release_ms = value;
+		b.release_coef = exp(-1000.0 / (b.release_ms * mb.samplerate));
+		break;
+	case MULTIBAND_MAKEUP:
+		if (!b.makeup_ramping) b.makeup_smoother.current = b.makeup_lin;
+		b.makeup = value;
+		b.makeup_lin = db_2_lin(b.makeup);
+		smoother_set_target(b.makeup_smoother, b.makeup_lin);
+		b.makeup_ramping = !smoother_settled(b.makeup_smoother);
+		break;
+	default:
+		break;
+	}
+}
+
+template <size_t channels>
+inline void multiband_init(multiband_n<channels>& mb, double samplerate)
+{
+	mb.samplerate = samplerate;
+
+	for (size_t ch = 0; ch < channels; ++ch) {
+		for (int s = 0; s < 2; ++s) {
+			butterworth* filters[] = {&mb.low_lp[ch][s], &mb.mid_hp[ch][s],
+									  &mb.mid_lp[ch][s], &mb.high_hp[ch][s]};
+			for (butterworth* f : filters) f->x1 = f->x2 = f->y1 = f->y2 = 0.0;
+		}
+	}
+	multiband_set_crossovers(mb, mb.low_mid_crossover, mb.mid_high_crossover);
+
+	for (int b = 0; b < MULTIBAND_BANDS; ++b) {
+		mb.bands[b].envelope_db = 0.f;
+		smoother_init(mb.bands[b].makeup_smoother, samplerate, MULTIBAND_MAKEUP_RAMP_MS);
+		multiband_update_band(mb, (multiband_band_index)b);
+	}
+}
+
+// runs the envelope and transfer function of a band over a chunk of rectified values
+inline void multiband_gain_chunk(multiband_band& b, const float* link, float* gain,
+								 int len)
+{
+	const float slope = 1.f / b.ratio - 1.f;
+	float envelope_db = b.envelope_db;
+
+	for (int i = 0; i < len; i++) {
+		float overshoot_db = fast_lin_2_db(link[i]) - b.threshold_db;
+		if (overshoot_db < 0.f) overshoot_db = 0.f;
+
+		float coef = overshoot_db > envelope_db ? b.attack_coef : b.release_coef;
+		envelope_db = overshoot_db + coef * (envelope_db - overshoot_db);
+		gain[i] = envelope_db;
+	}
+	b.envelope_db = envelope_db;
+
+	// transfer function, kept out of the envelope loop which is serial
+	for (int i = 0; i < len; i++) gain[i] = fast_db_2_lin(gain[i] * slope);
+}
+
+inline void multiband_apply_makeup(multiband_band& b, float* gain, int len)
+{
+	if (b.makeup_ramping) {
+		float makeup[MULTIBAND_CHUNK_SIZE];
+		b.makeup_ramping = !smoother_process_block(b.makeup_smoother, makeup, len);
+		for (int i = 0; i < len; i++) gain[i] *= makeup[i];
+	} else {
+		for (int i = 0; i < len; i++) gain[i] *= b.makeup_lin;
+	}
+}
+
+// multiband_process_block without publishing the meters, the levels of every band are
+// added to its meter_block
+template <typename sample, size_t channels>
+inline void multiband_process_frames(multiband_n<channels>& mb, sample** audio,
+									 int frames, dynamics_meter_block* meter_block)
+{
+	float band[MULTIBAND_BANDS][channels][MULTIBAND_CHUNK_SIZE];
+	float gain[MULTIBAND_BANDS][MULTIBAND_CHUNK_SIZE];
+
+	for (int offset = 0; offset < frames; offset += MULTIBAND_CHUNK_SIZE) {
+		int len = std::min(MULTIBAND_CHUNK_SIZE, frames - offset);
+
+		// split every channel once, the three bands are independent and overlap
+		for (size_t ch = 0; ch < channels; ch++) {
+			butterworth* low_lp = mb.low_lp[ch];
+			butterworth* mid_hp = mb.mid_hp[ch];
+			butterworth* mid_lp = mb.mid_lp[ch];
+			butterworth* high_hp = mb.high_hp[ch];
+
+			for (int i = 0; i < len; i++) {
+				double input = audio[ch][offset + i];
+
+				double low = butterworth_biquad_process(low_lp[0], input);
+				low = butterworth_biquad_process(low_lp[1], low);
+
+				double mid = butterworth_biquad_process(mid_hp[0], input);
+				mid = butterworth_biquad_process(mid_hp[1], mid);
+				mid = butterworth_biquad_process(mid_lp[0], mid);
+				mid = butterworth_biquad_process(mid_lp[1], mid);
+
+				double high = butterworth_biquad_process(high_hp[0], input);
+				high = butterworth_biquad_process(high_hp[1], high);
+
+				band[MULTIBAND_LOW][ch][i] = low;
+				band[MULTIBAND_MID][ch][i] = mid;
+				band[MULTIBAND_HIGH][ch][i] = high;
+			}
+		}
+
+		// detection and gain computer per band
+		for (int b = 0; b < MULTIBAND_BANDS; b++) {
+			float link[MULTIBAND_CHUNK_SIZE];
+			for (int i = 0; i < len; i++) {
+				float frame[channels];
+				for (size_t ch = 0; ch < channels; ch++) frame[ch] = band[b][ch][i];
+				link[i] = detection_link<channels>(mb.detection, frame);
+			}
+			multiband_gain_chunk(mb.bands[b], link, gain[b], len);
+
+			// the meter reports gain reduction without the makeup gain
+			dynamics_meter_add_gain(meter_block[b], gain[b], len);
+			multiband_apply_makeup(mb.bands[b], gain[b], len);
+			for (size_t ch = 0; ch < channels; ch++)
+				meter_block[b].input_peak =
+					dynamics_meter_peak(band[b][ch], len, meter_block[b].input_peak);
+		}
+
+		// apply gains and sum the bands in place
+		for (size_t ch = 0; ch < channels; ch++) {
+			sample* channel = audio[ch] + offset;
+			for (int b = 0; b < MULTIBAND_BANDS; b++) {
+				float* samples = band[b][ch];
+				for (int i = 0; i < len; i++) samples[i] *= gain[b][i];
+				meter_block[b].output_peak =
+					dynamics_meter_peak(samples, len, meter_block[b].output_peak);
+			}
+			for (int i = 0; i < len; i++) {
+				channel[i] = band[MULTIBAND_LOW][ch][i] + band[MULTIBAND_MID][ch][i] +
+							 band[MULTIBAND_HIGH][ch][i];
+			}
+		}
+	}
+}
+
+template <typename sample, size_t channels>
+inline void multiband_process_block(multiband_n<channels>& mb, sample** audio, int frames)
+{
+	dynamics_meter_block meter_block[MULTIBAND_BANDS];
+	multiband_process_frames(mb, audio, frames, meter_block);
+	for (int b = 0; b < MULTIBAND_BANDS; b++)
+		dynamics_meter_publish(mb.bands[b].meter, meter_block[b]);
+}
+
+// multiband_process_block with sample accurate automation, the event params are
+// multiband_event_param or a crossover. The meters are published once for the whole
+// block.
+template <typename sample, size_t channels>
+inline void multiband_process_block_events(multiband_n<channels>& mb, sample** audio,
+										   int frames, param_queue& q)
+{
+	auto view = audio_buffer_view_of<channels>(audio, frames);
+	dynamics_meter_block meter_block[MULTIBAND_BANDS];
+
+	param_queue_render(
+		q, frames,
+		[&](int offset, int len) {
+			auto sub = audio_buffer_view_frames(view, offset, len);
+			multiband_process_frames(mb, sub.channel_ptrs, len, meter_block);
+		},
+		[&](int param, float value) {
+			if (param == MULTIBAND_LOW_MID_CROSSOVER) {
+				multiband_set_crossovers(mb, value, mb.mid_high_crossover);
+			} else if (param == MULTIBAND_MID_HIGH_CROSSOVER) {
+				multiband_set_crossovers(mb, mb.low_mid_crossover, value);
+			} else if (param >= 0 && param < MULTIBAND_LOW_MID_CROSSOVER) {
+				auto index = (multiband_band_index)(param / MULTIBAND_BAND_PARAMS);
+				auto band_param = (multiband_param)(param % MULTIBAND_BAND_PARAMS);
+				multiband_set_param(mb, index, band_param, value);
+			}
+		});
+
+	for (int b = 0; b < MULTIBAND_BANDS; b++)
+		dynamics_meter_publish(mb.bands[b].meter, meter_block[b]);
+}
+} // namespace trnr
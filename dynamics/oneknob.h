@@ -24,8 +24,13 @@
 #pragma once
 
 #include "../util/audio_math.h"
+#include "../util/param_queue.h"
+#include "../util/smoother.h"
+#include "detection.h"
+#include "meter.h"
 #include "rms_detector.h"
 #include <algorithm>
+#include <array>
 #include <cmath>
 
 namespace trnr {
@@ -52,91 +57,323 @@ inline float hp_filter_process(hp_filter& f, float x)
 	return y;
 }
 
-struct oneknob_comp {
+// resolution of the program-dependent attack/release coefficient tables
+constexpr int ONEKNOB_TABLE_SIZE = 64;
+// number of frames the gain is computed for before it is applied to the audio
+constexpr int ONEKNOB_CHUNK_SIZE = 64;
+// time the ratio takes to follow a oneknob_set_param
+constexpr float ONEKNOB_RATIO_RAMP_MS = 20.f;
+
+template <size_t channels>
+struct oneknob_comp_n {
 	// params
 	float amount = 0.f;
 	bool multiplied = false;
+	detection_mode detection = DETECT_RMS;
 
-	// state
-	rms_detector detector;
-	hp_filter filter;
-	float attack_coef;
-	float release_coef;
-	float envelope_level;
-	float sidechain_in;
+	// per channel state, linked detection only uses the first detector/envelope
+	rms_detector detector[channels];
+	hp_filter filter[channels];
+	float attack_coef[channels];
+	float release_coef[channels];
+	float envelope_level[channels];
+	float sidechain_in[channels];
 	double samplerate;
-};
 
-inline void oneknob_init(oneknob_comp& c, double samplerate, float window_ms)
-{
-	rms_init(c.detector, samplerate, window_ms);
-	hp_filter_init(c.filter, samplerate);
+	// control rate mode, see oneknob_set_control_rate
+	int control_rate = 1;
+	int control_count = 0;
+	float gain_lin[channels];
+	float gain_inc[channels];
 
-	const float attack_ms = 0.2f;
-	const float release_ms = 150.f;
+	// ramp of the ratio after oneknob_set_param
+	bool ratio_ramping = false;
+	smoother ratio_smoother;
 
-	c.samplerate = samplerate;
-	c.attack_coef = expf(-1.0f / (attack_ms * 1e-6 * samplerate));
-	c.release_coef = expf(-1.0f / (release_ms * 1e-3 * samplerate));
-	c.envelope_level = -60.f;
-	c.sidechain_in = 0.f;
-}
+	// attack/release coefficients indexed by normalized gain reduction
+	std::array<float, ONEKNOB_TABLE_SIZE + 1> attack_table;
+	std::array<float, ONEKNOB_TABLE_SIZE + 1> release_table;
+
+	// gain reduction and levels of the last block for the ui, see dynamics_meter_read
+	dynamics_meter meter;
+};
+
+using oneknob_comp = oneknob_comp_n<2>;
 
-template <typename sample>
-inline void oneknob_process_block(oneknob_comp& c, sample** audio, int frames)
+enum oneknob_param { ONEKNOB_AMOUNT };
+
+// ratio of the transfer function for an amount
+inline float oneknob_ratio(float amount)
 {
 	const float min_user_ratio = 1.0f;
 	const float max_user_ratio = 20.0f;
-	const float threshold_db = -12.f;
 
-	const float amount = fmaxf(0.0f, fminf(powf(c.amount, 2.f), 1.0f));
-	float ratio = min_user_ratio + amount * (max_user_ratio - min_user_ratio);
+	amount = fmaxf(0.0f, fminf(powf(amount, 2.f), 1.0f));
+	return min_user_ratio + amount * (max_user_ratio - min_user_ratio);
+}
+
+// ramps the ratio to the new amount over ONEKNOB_RATIO_RAMP_MS, writing amount directly
+// changes it at the next block
+template <size_t channels>
+inline void oneknob_set_param(oneknob_comp_n<channels>& c, oneknob_param param,
+							  float value)
+{
+	switch (param) {
+	case ONEKNOB_AMOUNT: {
+		smoother& ramp = c.ratio_smoother;
+		if (!c.ratio_ramping) ramp.current = oneknob_ratio(c.amount);
+		c.amount = value;
+		smoother_set_target(ramp, oneknob_ratio(value));
+		c.ratio_ramping = !smoother_settled(ramp);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+template <size_t channels>
+inline float oneknob_get_param(const oneknob_comp_n<channels>& c, oneknob_param param)
+{
+	switch (param) {
+	case ONEKNOB_AMOUNT:
+		return c.amount;
+	default:
+		return -1.f;
+	}
+}
 
+// the tables only depend on the samplerate and control rate, so they are built once
+// on init and when the control rate changes
+template <size_t channels>
+inline void oneknob_build_tables(oneknob_comp_n<channels>& c)
+{
 	const float fast_attack = 0.1f;
 	const float slow_attack = 0.6f;
 	const float fast_release = 90.f;
 	const float slow_release = 300.f;
+
+	for (int i = 0; i <= ONEKNOB_TABLE_SIZE; ++i) {
+		float norm_gr = (float)i / ONEKNOB_TABLE_SIZE;
+		float release_ms = fast_release + (slow_release - fast_release) * (1.f - norm_gr);
+		float attack_ms = fast_attack + (slow_attack - fast_attack) * (1.f - norm_gr);
+
+		// coefficients advance the envelope by control_rate samples at once
+		float steps = (float)c.control_rate;
+		c.attack_table[i] = expf(-steps / (attack_ms * 1e-6 * c.samplerate));
+		c.release_table[i] = expf(-steps / (release_ms * 1e-3 * c.samplerate));
+	}
+}
+
+inline float oneknob_table_lookup(const std::array<float, ONEKNOB_TABLE_SIZE + 1>& table,
+								  float norm_gr)
+{
+	float pos = norm_gr * ONEKNOB_TABLE_SIZE;
+	int index = std::min((int)pos, ONEKNOB_TABLE_SIZE - 1);
+	float frac = pos - index;
+	return table[index] + (table[index + 1] - table[index]) * frac;
+}
+
+template <size_t channels>
+inline void oneknob_init(oneknob_comp_n<channels>& c, double samplerate, float window_ms)
+{
+	const float attack_ms = 0.2f;
+	const float release_ms = 150.f;
+
+	c.samplerate = samplerate;
+
+	for (size_t ch = 0; ch < channels; ++ch) {
+		rms_init(c.detector[ch], samplerate, window_ms);
+		hp_filter_init(c.filter[ch], samplerate);
+
+		c.attack_coef[ch] = expf(-1.0f / (attack_ms * 1e-6 * samplerate));
+		c.release_coef[ch] = expf(-1.0f / (release_ms * 1e-3 * samplerate));
+		c.envelope_level[ch] = -60.f;
+		c.sidechain_in[ch] = 0.f;
+		c.gain_lin[ch] = 1.f;
+		c.gain_inc[ch] = 0.f;
+	}
+	c.control_count = 0;
+
+	smoother_init(c.ratio_smoother, samplerate, ONEKNOB_RATIO_RAMP_MS);
+	c.ratio_ramping = false;
+
+	oneknob_build_tables(c);
+}
+
+// Evaluates the gain computer only every n samples and ramps the gain linearly in
+// between. n = 1 computes the gain for every sample (default). The gain reacts n to
+// 2n - 1 samples later than with n = 1.
+//
+// trnr-bench --control-rate --blocks 256, amount 0.5, 10 ms window, 2.6 kHz bursts
+// between -20 and 0 dBFS at 48 kHz, stereo:
+//
+//   n    thd+n     max gain deviation from n = 1   ns/sample
+//   1    -99.7 dB  -                               38.4
+//   4    -97.0 dB  0.27 dB                         16.7
+//   8    -94.0 dB  0.29 dB                         12.1
+//   16   -91.7 dB  0.56 dB                         9.6
+//   32   -90.1 dB  0.94 dB                         8.8
+template <size_t channels>
+inline void oneknob_set_control_rate(oneknob_comp_n<channels>& c, int n)
+{
+	c.control_rate = std::max(1, n);
+	c.control_count = 0;
+	// the ramp of the old rate would run on until the next evaluation
+	for (size_t ch = 0; ch < channels; ++ch) c.gain_inc[ch] = 0.f;
+	oneknob_build_tables(c);
+}
+
+// runs the envelope and transfer function, returns the linear gain reduction
+template <size_t channels>
+inline float oneknob_gain_computer(oneknob_comp_n<channels>& c, size_t ch,
+								   float rms_value, float ratio)
+{
+	const float threshold_db = -12.f;
 	const float max_gr = 12.f;
 
-	for (int i = 0; i < frames; ++i) {
-		float rms_value = rms_process<sample>(c.detector, c.sidechain_in);
-		float envelope_in = lin_2_db(fmaxf(fabs(rms_value), 1e-20f));
+	float envelope_in = fast_lin_2_db(fmaxf(fabs(rms_value), 1e-20f));
+	float& envelope_level = c.envelope_level[ch];
 
-		// attack
-		if (envelope_in > c.envelope_level) {
-			c.envelope_level =
-				envelope_in + c.attack_coef * (c.envelope_level - envelope_in);
-		}
-		// release
-		else {
-			c.envelope_level =
-				envelope_in + c.release_coef * (c.envelope_level - envelope_in);
+	// attack
+	if (envelope_in > envelope_level) {
+		envelope_level = envelope_in + c.attack_coef[ch] * (envelope_level - envelope_in);
+	}
+	// release
+	else {
+		envelope_level =
+			envelope_in + c.release_coef[ch] * (envelope_level - envelope_in);
+	}
+
+	float x = envelope_level;
+	float y;
+
+	if (x < threshold_db) y = x;
+	else y = threshold_db + (x - threshold_db) / ratio;
+
+	float gain_reduction_db = y - x;
+
+	// program-dependent attack/release times
+	float norm_gr = std::clamp(gain_reduction_db / max_gr, 0.f, 1.f);
+	c.attack_coef[ch] = oneknob_table_lookup(c.attack_table, norm_gr);
+	c.release_coef[ch] = oneknob_table_lookup(c.release_table, norm_gr);
+
+	return fast_db_2_lin(gain_reduction_db);
+}
+
+// oneknob_process_block without publishing the meter, the levels are added to
+// meter_block
+template <typename sample, size_t channels>
+inline void oneknob_process_frames(oneknob_comp_n<channels>& c, sample** audio,
+								   int frames, dynamics_meter_block& meter_block)
+{
+	const float ratio = oneknob_ratio(c.amount);
+
+	const bool unlinked = c.detection == DETECT_UNLINKED;
+	const size_t detectors = unlinked ? channels : 1;
+
+	float gain[channels][ONEKNOB_CHUNK_SIZE];
+
+	for (int offset = 0; offset < frames; offset += ONEKNOB_CHUNK_SIZE) {
+		int len = std::min(ONEKNOB_CHUNK_SIZE, frames - offset);
+
+		// the ratio of every frame while it ramps
+		float ratios[ONEKNOB_CHUNK_SIZE];
+		const bool ramping = c.ratio_ramping;
+		if (ramping)
+			c.ratio_ramping = !smoother_process_block(c.ratio_smoother, ratios, len);
+
+		// input levels, once per frame
+		float level[channels][ONEKNOB_CHUNK_SIZE];
+		if (unlinked) {
+			for (size_t ch = 0; ch < channels; ++ch)
+				for (int i = 0; i < len; ++i)
+					level[ch][i] = std::fabs(audio[ch][offset + i]);
+		} else {
+			for (int i = 0; i < len; ++i) {
+				float frame[channels];
+				for (size_t ch = 0; ch < channels; ++ch)
+					frame[ch] = audio[ch][offset + i];
+				level[0][i] = detection_link<channels>(c.detection, frame);
+			}
 		}
 
-		float x = c.envelope_level;
-		float y;
+		int control_count = c.control_count;
 
-		if (x < threshold_db) y = x;
-		else y = threshold_db + (x - threshold_db) / ratio;
+		for (size_t ch = 0; ch < detectors; ++ch) {
+			control_count = c.control_count;
 
-		float gain_reduction_db = y - x;
-		float gain_reduction_lin = db_2_lin(gain_reduction_db);
+			for (int i = 0; i < len; ++i) {
+				float frame_ratio = ramping ? ratios[i] : ratio;
 
-		audio[0][i] *= gain_reduction_lin;
-		audio[1][i] *= gain_reduction_lin;
+				if (c.control_rate > 1) {
+					rms_accumulate(c.detector[ch], c.sidechain_in[ch]);
 
-		// calculate program-dependent attack/release times
-		float norm_gr = std::clamp(gain_reduction_db / max_gr, 0.f, 1.f);
-		float release_ms = fast_release + (slow_release - fast_release) * (1.f - norm_gr);
-		float attack_ms = fast_attack + (slow_attack - fast_attack) * (1.f - norm_gr);
+					if (++control_count >= c.control_rate) {
+						float target = oneknob_gain_computer(
+							c, ch, rms_value(c.detector[ch]), frame_ratio);
+						c.gain_inc[ch] = (target - c.gain_lin[ch]) / c.control_rate;
+						control_count = 0;
+					}
+					c.gain_lin[ch] += c.gain_inc[ch];
+				} else {
+					float rms = rms_process<sample>(c.detector[ch], c.sidechain_in[ch]);
+					c.gain_lin[ch] = oneknob_gain_computer(c, ch, rms, frame_ratio);
+				}
+				gain[ch][i] = c.gain_lin[ch];
+
+				// feedback compression, the output level is the input level times the
+				// gain
+				float sum = level[ch][i] * gain[ch][i];
+				if (c.multiplied) sum *= 3.f;
+				c.sidechain_in[ch] = hp_filter_process(c.filter[ch], sum);
+			}
+		}
 
-		c.attack_coef = expf(-1.0f / (attack_ms * 1e-6 * c.samplerate));
-		c.release_coef = expf(-1.0f / (release_ms * 1e-3 * c.samplerate));
+		c.control_count = control_count;
 
-		// feedback compression
-		float sum = sqrtf(0.5f * (audio[0][i] * audio[0][i] + audio[1][i] * audio[1][i]));
-		if (c.multiplied) sum *= 3.f;
-		c.sidechain_in = hp_filter_process(c.filter, sum);
+		for (size_t ch = 0; ch < detectors; ch++)
+			dynamics_meter_add_gain(meter_block, gain[ch], len);
+
+		for (size_t ch = 0; ch < channels; ++ch) {
+			const float* channel_gain = gain[unlinked ? ch : 0];
+			sample* channel = audio[ch] + offset;
+			meter_block.input_peak =
+				dynamics_meter_peak(channel, len, meter_block.input_peak);
+			for (int i = 0; i < len; ++i) channel[i] *= channel_gain[i];
+			meter_block.output_peak =
+				dynamics_meter_peak(channel, len, meter_block.output_peak);
+		}
 	}
 }
+
+template <typename sample, size_t channels>
+inline void oneknob_process_block(oneknob_comp_n<channels>& c, sample** audio, int frames)
+{
+	dynamics_meter_block meter_block;
+	oneknob_process_frames(c, audio, frames, meter_block);
+	dynamics_meter_publish(c.meter, meter_block);
+}
+
+// oneknob_process_block with sample accurate automation, the event params are
+// oneknob_param. The meter is published once for the whole block.
+template <typename sample, size_t channels>
+inline void oneknob_process_block_events(oneknob_comp_n<channels>& c, sample** audio,
+										 int frames, param_queue& q)
+{
+	auto view = audio_buffer_view_of<channels>(audio, frames);
+	dynamics_meter_block meter_block;
+
+	param_queue_render(
+		q, frames,
+		[&](int offset, int len) {
+			auto sub = audio_buffer_view_frames(view, offset, len);
+			oneknob_process_frames(c, sub.channel_ptrs, len, meter_block);
+		},
+		[&](int param, float value) {
+			oneknob_set_param(c, (oneknob_param)param, value);
+		});
+
+	dynamics_meter_publish(c.meter, meter_block);
+}
 } // namespace trnr
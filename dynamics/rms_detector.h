@@ -44,4 +44,13 @@ inline sample rms_process(rms_detector& d, sample input)
 	d.rms_squared = (1.0f - d.alpha) * d.rms_squared + d.alpha * (input * input);
 	return sqrtf(d.rms_squared);
 }
+
+// updates the detector without taking the square root, read it with rms_value
+template <typename sample>
+inline void rms_accumulate(rms_detector& d, sample input)
+{
+	d.rms_squared = (1.0f - d.alpha) * d.rms_squared + d.alpha * (input * input);
+}
+
+inline float rms_value(const rms_detector& d) { return sqrtf(d.rms_squared); }
 } // namespace trnr
@@ -0,0 +1,185 @@
+/*
+ * window_detector.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../util/audio_math.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace trnr {
+
+////////////////////////
+// SLIDING WINDOW RMS //
+////////////////////////
+
+// Exact RMS over the last `window` samples. Keeps the squared samples in a ring buffer
+// and a running sum per channel, the square root is only taken when a value is read.
+struct window_rms {
+	size_t channels;
+	size_t window;
+	size_t pos;
+	std::vector<float> squares; // channels * window, one ring per channel
+	std::vector<double> sum;	// double so adding/removing does not drift
+};
+
+inline void window_rms_init(window_rms& d, size_t channels, size_t window_samples)
+{
+	d.channels = channels;
+	d.window = std::max<size_t>(1, window_samples);
+	d.pos = 0;
+	d.squares.assign(d.channels * d.window, 0.f);
+	d.sum.assign(d.channels, 0.0);
+}
+
+inline void window_rms_init(window_rms& d, size_t channels, double samplerate,
+							float window_ms)
+{
+	window_rms_init(d, channels, (size_t)ms_to_samples(window_ms, samplerate));
+}
+
+// Feeds a block of samples. If `mean_squares` is not null, the mean square of every
+// channel after each sample is written to it (same layout as `inputs`).
+template <typename sample>
+inline void window_rms_process_block(window_rms& d, sample** inputs, int frames,
+									 float** mean_squares = nullptr)
+{
+	const double norm = 1.0 / d.window;
+	size_t pos = d.pos;
+
+	for (size_t ch = 0; ch < d.channels; ++ch) {
+		float* ring = d.squares.data() + ch * d.window;
+		double sum = d.sum[ch];
+		pos = d.pos;
+
+		for (int i = 0; i < frames; ++i) {
+			float square = (float)inputs[ch][i] * (float)inputs[ch][i];
+			sum += (double)square - ring[pos];
+			ring[pos] = square;
+			if (++pos == d.window) pos = 0;
+
+			if (mean_squares) mean_squares[ch][i] = (float)(std::max(sum, 0.0) * norm);
+		}
+		d.sum[ch] = sum;
+	}
+	d.pos = pos;
+}
+
+inline float window_rms_value(const window_rms& d, size_t channel)
+{
+	return sqrtf((float)(std::max(d.sum[channel], 0.0) / d.window));
+}
+
+/////////////////////////
+// SLIDING WINDOW PEAK //
+/////////////////////////
+
+// Exact peak (max of the absolute value) over the last `window` samples using a
+// monotonic deque per channel, O(1) amortized per sample.
+struct window_peak {
+	size_t channels;
+	size_t window;
+	size_t capacity;
+	uint64_t time;
+	std::vector<float> values;	  // channels * capacity, decreasing from head to tail
+	std::vector<uint64_t> stamps; // sample time the value was pushed
+	std::vector<size_t> head;
+	std::vector<size_t> size;
+};
+
+inline void window_peak_init(window_peak& d, size_t channels, size_t window_samples)
+{
+	d.channels = channels;
+	d.window = std::max<size_t>(1, window_samples);
+	d.capacity = d.window + 1;
+	d.time = 0;
+	d.values.assign(d.channels * d.capacity, 0.f);
+	d.stamps.assign(d.channels * d.capacity, 0);
+	d.head.assign(d.channels, 0);
+	d.size.assign(d.channels, 0);
+}
+
+inline void window_peak_init(window_peak& d, size_t channels, double samplerate,
+							 float window_ms)
+{
+	window_peak_init(d, channels, (size_t)ms_to_samples(window_ms, samplerate));
+}
+
+// pushes one (already rectified) value and returns the peak of the current window
+inline float window_peak_push(window_peak& d, size_t channel, float value, uint64_t time)
+{
+	float* values = d.values.data() + channel * d.capacity;
+	uint64_t* stamps = d.stamps.data() + channel * d.capacity;
+	size_t head = d.head[channel];
+	size_t size = d.size[channel];
+
+	// drop smaller values from the tail, they can never be the peak again
+	while (size > 0) {
+		size_t tail = head + size - 1;
+		if (tail >= d.capacity) tail -= d.capacity;
+		if (values[tail] > value) break;
+		--size;
+	}
+
+	size_t tail = head + size;
+	if (tail >= d.capacity) tail -= d.capacity;
+	values[tail] = value;
+	stamps[tail] = time;
+	++size;
+
+	// drop the head once it left the window
+	if (stamps[head] + d.window <= time) {
+		if (++head == d.capacity) head = 0;
+		--size;
+	}
+
+	d.head[channel] = head;
+	d.size[channel] = size;
+	return values[head];
+}
+
+// Feeds a block of samples. If `peaks` is not null, the window peak of every channel
+// after each sample is written to it (same layout as `inputs`).
+template <typename sample>
+inline void window_peak_process_block(window_peak& d, sample** inputs, int frames,
+									  float** peaks = nullptr)
+{
+	for (size_t ch = 0; ch < d.channels; ++ch) {
+		uint64_t time = d.time;
+		for (int i = 0; i < frames; ++i) {
+			float peak = window_peak_push(d, ch, std::fabs((float)inputs[ch][i]), time++);
+			if (peaks) peaks[ch][i] = peak;
+		}
+	}
+	d.time += frames;
+}
+
+inline float window_peak_value(const window_peak& d, size_t channel)
+{
+	if (d.size[channel] == 0) return 0.f;
+	return d.values[channel * d.capacity + d.head[channel]];
+}
+} // namespace trnr
@@ -24,9 +24,11 @@
 #pragma once
 
 #include "../util/audio_math.h"
+#include "../util/param_queue.h"
 #include "../util/smoother.h"
+#include <algorithm>
+#include <cassert>
 #include <cmath>
-#include <vector>
 
 namespace trnr {
 
@@ -36,28 +38,32 @@ enum filter_type {
 	HIGHPASS = 1
 };
 
+// stages a cascade_filter holds, the state is part of the struct so that setting it up
+// on the audio thread never allocates
+constexpr int CASCADE_MAX_STAGES = 4;
+
 struct cascade_filter {
 	filter_type type;
-	int stages;				   // Number of cascaded stages
-	double cutoff;			   // Cutoff frequency (Hz)
-	double samplerate;		   // Sample rate (Hz)
-	double alpha;			   // Filter coefficient
-	std::vector<double> state; // State per stage
+	int stages;							   // Number of cascaded stages
+	double cutoff;						   // Cutoff frequency (Hz)
+	double samplerate;					   // Sample rate (Hz)
+	double alpha;						   // Filter coefficient
+	double state[CASCADE_MAX_STAGES] = {}; // State per stage
 };
 
 inline void cascade_filter_setup(cascade_filter& f, filter_type _type, int _stages,
 								 double _cutoff, double _samplerate)
 {
+	assert(_stages <= CASCADE_MAX_STAGES && "raise CASCADE_MAX_STAGES");
+
 	f.type = _type;
-	f.stages = _stages;
+	f.stages = std::min(_stages, CASCADE_MAX_STAGES);
 	f.cutoff = _cutoff;
 	f.samplerate = _samplerate;
 
 	// alpha = iirAmount = exp(-2 * pi * cutoff / samplerate);
 	double x = exp(-2.0 * M_PI * f.cutoff / f.samplerate);
 	f.alpha = 1.0 - x;
-
-	f.state.resize(f.stages, 0.0);
 }
 
 // Process one sample
@@ -115,6 +121,11 @@ inline void butterworth_biquad_coeffs(butterworth& b, double samplerate)
 	}
 }
 
+// spliteq takes the crossovers as nominal band edges and runs its Linkwitz-Riley
+// cascades at half of them. Modules sharing the crossover go through this so the same
+// numbers split the spectrum at the same place.
+inline double spliteq_crossover_cutoff(double crossover) { return crossover / 2.0; }
+
 // Biquad sample processing
 inline double butterworth_biquad_process(butterworth& b, double input)
 {
@@ -251,11 +262,41 @@ inline void aw_filter_process_block(aw_filter& f, float* audio, int frames)
 	}
 }
 
+// longest stretch of the mode transition and gain ramps computed at once
+constexpr int SPLITEQ_CHUNK_SIZE = 64;
+// time the band gains take to follow a spliteq_set_param
+constexpr float SPLITEQ_GAIN_RAMP_MS = 20.f;
+
 enum spliteq_mode {
 	CASCADE_SUM,
 	LINKWITZ_RILEY
 };
 
+// parameters for spliteq_set_param, the first seven are the spliteq_update arguments
+enum spliteq_param {
+	SPLITEQ_HP_FREQ,
+	SPLITEQ_LP_FREQ,
+	SPLITEQ_LOW_MID_CROSSOVER,
+	SPLITEQ_MID_HIGH_CROSSOVER,
+	SPLITEQ_BASS_GAIN,
+	SPLITEQ_MID_GAIN,
+	SPLITEQ_TREBLE_GAIN,
+	SPLITEQ_MODE
+};
+
+constexpr int SPLITEQ_UPDATE_PARAMS = SPLITEQ_MODE;
+
+// the linear band gains of both modes, ramped together by spliteq_set_param
+enum spliteq_gain {
+	SPLITEQ_GAIN_BASS,
+	SPLITEQ_GAIN_MID,
+	SPLITEQ_GAIN_TREBLE,
+	SPLITEQ_GAIN_BASS_ADJ,
+	SPLITEQ_GAIN_MID_ADJ,
+	SPLITEQ_GAIN_TREBLE_ADJ,
+	SPLITEQ_GAINS
+};
+
 struct spliteq {
 	aw_filter lp_l, lp_r, hp_l, hp_r; // lowpass and highpass filters
 
@@ -293,13 +334,82 @@ struct spliteq {
 	spliteq_mode target_mode = CASCADE_SUM;
 	bool transitioning = false;
 	smoother transition_smoother;
+
+	// ramps of the gains above, indexed by spliteq_gain
+	bool gains_ramping = false;
+	smoother_bank<SPLITEQ_GAINS> gain_smoother;
+
+	// arguments of the last spliteq_update, indexed by spliteq_param
+	double update_params[SPLITEQ_UPDATE_PARAMS];
 };
 
+// the gain fields in spliteq_gain order
+constexpr float spliteq::*SPLITEQ_GAIN_FIELDS[SPLITEQ_GAINS] = {
+	&spliteq::bass_gain,	 &spliteq::mid_gain,	 &spliteq::treble_gain,
+	&spliteq::bass_gain_adj, &spliteq::mid_gain_adj, &spliteq::treble_gain_adj};
+
+// sets the gains at once and stops their ramps
+inline void spliteq_set_gains(spliteq& eq, const float* gains)
+{
+	for (int g = 0; g < SPLITEQ_GAINS; g++) {
+		eq.*SPLITEQ_GAIN_FIELDS[g] = gains[g];
+		eq.gain_smoother.current[g] = gains[g];
+		eq.gain_smoother.target[g] = gains[g];
+		eq.gain_smoother.increment[g] = 0.f;
+		eq.gain_smoother.remaining[g] = 0;
+	}
+	eq.gains_ramping = false;
+}
+
+// ramps the gains from where they are to gains over SPLITEQ_GAIN_RAMP_MS
+inline void spliteq_ramp_gains(spliteq& eq, const float* gains)
+{
+	for (int g = 0; g < SPLITEQ_GAINS; g++) {
+		eq.gain_smoother.current[g] = eq.*SPLITEQ_GAIN_FIELDS[g];
+		smoother_bank_set_target(eq.gain_smoother, g, gains[g]);
+	}
+	eq.gains_ramping = true;
+}
+
+// linear gains of the update_params in dB, in spliteq_gain order. the cascade sum gains
+// are adjusted for the overlap of its bands.
+inline void spliteq_linear_gains(const spliteq& eq, float* gains)
+{
+	double bass_gain = eq.update_params[SPLITEQ_BASS_GAIN];
+	double mid_gain = eq.update_params[SPLITEQ_MID_GAIN];
+	double treble_gain = eq.update_params[SPLITEQ_TREBLE_GAIN];
+
+	gains[SPLITEQ_GAIN_BASS] = db_2_lin(bass_gain);
+	gains[SPLITEQ_GAIN_MID] = db_2_lin(mid_gain);
+	gains[SPLITEQ_GAIN_TREBLE] = db_2_lin(treble_gain);
+
+	if (bass_gain > 0.f) {
+		gains[SPLITEQ_GAIN_BASS] = db_2_lin(bass_gain * 0.85f);
+		gains[SPLITEQ_GAIN_BASS_ADJ] = gains[SPLITEQ_GAIN_BASS];
+	} else {
+		gains[SPLITEQ_GAIN_BASS_ADJ] = db_2_lin(bass_gain);
+	}
+
+	if (mid_gain > 0.0f) gains[SPLITEQ_GAIN_MID_ADJ] = db_2_lin(mid_gain * 0.85f);
+	else gains[SPLITEQ_GAIN_MID_ADJ] = db_2_lin(mid_gain * 0.74f);
+
+	if (treble_gain > 0.f) gains[SPLITEQ_GAIN_TREBLE_ADJ] = db_2_lin(treble_gain * 1.1f);
+	else gains[SPLITEQ_GAIN_TREBLE_ADJ] = db_2_lin(treble_gain);
+}
+
 inline void spliteq_init(spliteq& eq, double samplerate, double low_mid_crossover,
 						 double mid_high_crossover)
 {
-	low_mid_crossover /= 2.0;
-	mid_high_crossover /= 2.0;
+	eq.update_params[SPLITEQ_HP_FREQ] = 0.0;
+	eq.update_params[SPLITEQ_LP_FREQ] = 1.0;
+	eq.update_params[SPLITEQ_LOW_MID_CROSSOVER] = low_mid_crossover;
+	eq.update_params[SPLITEQ_MID_HIGH_CROSSOVER] = mid_high_crossover;
+	eq.update_params[SPLITEQ_BASS_GAIN] = 0.0;
+	eq.update_params[SPLITEQ_MID_GAIN] = 0.0;
+	eq.update_params[SPLITEQ_TREBLE_GAIN] = 0.0;
+
+	low_mid_crossover = spliteq_crossover_cutoff(low_mid_crossover);
+	mid_high_crossover = spliteq_crossover_cutoff(mid_high_crossover);
 
 	eq.samplerate = samplerate;
 
@@ -405,6 +515,12 @@ inline void spliteq_init(spliteq& eq, double samplerate, double low_mid_crossove
 	butterworth_biquad_coeffs(eq.treble2_r, samplerate);
 
 	smoother_init(eq.transition_smoother, samplerate, 50.0f, 1.0f);
+	smoother_bank_init(eq.gain_smoother, samplerate, SPLITEQ_GAIN_RAMP_MS);
+	for (int g = 0; g < SPLITEQ_GAINS; g++) {
+		float gain = eq.*SPLITEQ_GAIN_FIELDS[g];
+		eq.gain_smoother.current[g] = eq.gain_smoother.target[g] = gain;
+	}
+	eq.gains_ramping = false;
 }
 
 inline void spliteq_set_mode(spliteq& eq, spliteq_mode mode)
@@ -487,34 +603,78 @@ inline void cascade_sum_process(spliteq& eq, float**& audio, int& i)
 	audio[1][i] = bass_r + mid_r + treble_r;
 }
 
+// band split and sum of frames start to end in the current mode
+inline void spliteq_process_bands(spliteq& eq, float** audio, int start, int end)
+{
+	// while the gains ramp, they are updated before every frame
+	while (eq.gains_ramping && start < end) {
+		int len = std::min(end - start, SPLITEQ_CHUNK_SIZE);
+
+		float ramps[SPLITEQ_GAINS][SPLITEQ_CHUNK_SIZE];
+		float* out[SPLITEQ_GAINS];
+		for (int g = 0; g < SPLITEQ_GAINS; g++) out[g] = ramps[g];
+		eq.gains_ramping = !smoother_bank_process_block(eq.gain_smoother, out, len);
+
+		for (int i = 0; i < len; i++) {
+			for (int g = 0; g < SPLITEQ_GAINS; g++)
+				eq.*SPLITEQ_GAIN_FIELDS[g] = ramps[g][i];
+
+			int frame = start + i;
+			if (eq.current_mode == LINKWITZ_RILEY)
+				linkwitz_riley_process(eq, audio, frame);
+			else cascade_sum_process(eq, audio, frame);
+		}
+		start += len;
+	}
+
+	if (eq.current_mode == LINKWITZ_RILEY) {
+		for (int i = start; i < end; i++) linkwitz_riley_process(eq, audio, i);
+	} else if (eq.current_mode == CASCADE_SUM) {
+		for (int i = start; i < end; i++) cascade_sum_process(eq, audio, i);
+	}
+}
+
 inline void spliteq_process_block(spliteq& eq, float** audio, int frames)
 {
 	// highpass filters
 	aw_filter_process_block(eq.hp_l, audio[0], frames);
 	aw_filter_process_block(eq.hp_r, audio[1], frames);
 
-	for (int i = 0; i < frames; i++) {
-		float smooth_gain = 1.0f;
-
-		if (eq.transitioning) {
-			smooth_gain = smoother_process_sample(eq.transition_smoother);
-
-			if (smooth_gain == 0.f) {
-				smoother_set_target(eq.transition_smoother, 1.0);
-				eq.current_mode = eq.target_mode;
-			} else if (smooth_gain == 1.f) {
-				eq.transitioning = false;
-			}
+	int offset = 0;
+	while (offset < frames) {
+		// no mode change pending, no gain to apply
+		if (!eq.transitioning) {
+			spliteq_process_bands(eq, audio, offset, frames);
+			break;
 		}
 
-		if (eq.current_mode == LINKWITZ_RILEY) {
-			linkwitz_riley_process(eq, audio, i);
-		} else if (eq.current_mode == CASCADE_SUM) {
-			cascade_sum_process(eq, audio, i);
+		// the chunk ends with the ramp at the latest, so the mode change can happen on
+		// its last frame
+		smoother& ramp = eq.transition_smoother;
+		int len = std::min(frames - offset, SPLITEQ_CHUNK_SIZE);
+		if (ramp.remaining > 0) len = std::min(len, (int)ramp.remaining);
+		else len = 1;
+
+		float smooth_gain[SPLITEQ_CHUNK_SIZE];
+		bool settled = smoother_process_block(ramp, smooth_gain, len);
+		int last = offset + len - 1;
+
+		if (settled && smooth_gain[len - 1] == 0.f) {
+			// faded out, switch the mode for the last frame and fade back in
+			spliteq_process_bands(eq, audio, offset, last);
+			smoother_set_target(ramp, 1.0);
+			eq.current_mode = eq.target_mode;
+			spliteq_process_bands(eq, audio, last, last + 1);
+		} else {
+			spliteq_process_bands(eq, audio, offset, last + 1);
+			if (settled && smooth_gain[len - 1] == 1.f) eq.transitioning = false;
 		}
 
-		audio[0][i] *= smooth_gain;
-		audio[1][i] *= smooth_gain;
+		for (int i = 0; i < len; i++) {
+			audio[0][offset + i] *= smooth_gain[i];
+			audio[1][offset + i] *= smooth_gain[i];
+		}
+		offset += len;
 	}
 
 	// lowpass filters
@@ -522,86 +682,75 @@ inline void spliteq_process_block(spliteq& eq, float** audio, int frames)
 	aw_filter_process_block(eq.lp_r, audio[1], frames);
 }
 
-inline void spliteq_update(spliteq& eq, double hp_freq, double lp_freq,
-						   double low_mid_crossover, double mid_high_crossover,
-						   double bass_gain, double mid_gain, double treble_gain)
+// coefficients of the filters at the low/mid crossover from update_params, keeps their
+// state. the cascade crossover depends on the sign of the bass gain.
+inline void spliteq_update_low_mid(spliteq& eq)
 {
-	low_mid_crossover /= 2.0;
-	mid_high_crossover /= 2.0;
+	double crossover =
+		spliteq_crossover_cutoff(eq.update_params[SPLITEQ_LOW_MID_CROSSOVER]);
 
-	eq.bass_gain = db_2_lin(bass_gain);
-	eq.mid_gain = db_2_lin(mid_gain);
-	eq.treble_gain = db_2_lin(treble_gain);
+	eq.low_mid_crossover = crossover;
+	bool boost = eq.update_params[SPLITEQ_BASS_GAIN] > 0.f;
+	eq.low_mid_crossover_adj = boost ? crossover : crossover * 2.0;
 
-	if (bass_gain > 0.f) {
-		eq.bass_gain = eq.bass_gain_adj = db_2_lin(bass_gain * 0.85f);
-		eq.low_mid_crossover_adj = low_mid_crossover;
-	} else {
-		eq.bass_gain_adj = db_2_lin(bass_gain);
-		eq.low_mid_crossover_adj = low_mid_crossover * 2.0;
-	}
-
-	if (mid_gain > 0.0f) eq.mid_gain_adj = db_2_lin(mid_gain * 0.85f);
-	else eq.mid_gain_adj = db_2_lin(mid_gain * 0.74f);
+	cascade_filter_setup(eq.bass_l, LOWPASS, 2, eq.low_mid_crossover_adj, eq.samplerate);
+	cascade_filter_setup(eq.bass_r, LOWPASS, 2, eq.low_mid_crossover_adj, eq.samplerate);
 
-	if (treble_gain > 0.f) {
-		eq.treble_gain_adj = db_2_lin(treble_gain * 1.1f);
-		eq.mid_high_crossover_adj = mid_high_crossover;
-	} else {
-		eq.treble_gain_adj = db_2_lin(treble_gain);
-		eq.mid_high_crossover_adj = mid_high_crossover / 2.0;
+	butterworth* filters[] = {&eq.bass1_l,	 &eq.bass2_l,	&eq.bass1_r,   &eq.bass2_r,
+							  &eq.mid_hp1_l, &eq.mid_hp2_l, &eq.mid_hp1_r, &eq.mid_hp2_r};
+	for (butterworth* f : filters) {
+		f->cutoff = crossover;
+		butterworth_biquad_coeffs(*f, eq.samplerate);
 	}
+}
 
-	eq.low_mid_crossover = low_mid_crossover;
-	eq.mid_high_crossover = mid_high_crossover;
+// same for the mid/high crossover, the cascade one depends on the sign of the treble gain
+inline void spliteq_update_mid_high(spliteq& eq)
+{
+	double crossover =
+		spliteq_crossover_cutoff(eq.update_params[SPLITEQ_MID_HIGH_CROSSOVER]);
 
-	eq.hp_l.amount = hp_freq;
-	eq.hp_r.amount = hp_freq;
-	eq.lp_l.amount = lp_freq;
-	eq.lp_r.amount = lp_freq;
+	eq.mid_high_crossover = crossover;
+	bool boost = eq.update_params[SPLITEQ_TREBLE_GAIN] > 0.f;
+	eq.mid_high_crossover_adj = boost ? crossover : crossover / 2.0;
 
-	cascade_filter_setup(eq.bass_l, LOWPASS, 2, eq.low_mid_crossover_adj, eq.samplerate);
-	cascade_filter_setup(eq.bass_r, LOWPASS, 2, eq.low_mid_crossover_adj, eq.samplerate);
 	cascade_filter_setup(eq.treble_l, HIGHPASS, 2, eq.mid_high_crossover_adj,
 						 eq.samplerate);
 	cascade_filter_setup(eq.treble_r, HIGHPASS, 2, eq.mid_high_crossover_adj,
 						 eq.samplerate);
 
-	eq.bass1_l.cutoff = low_mid_crossover;
-	butterworth_biquad_coeffs(eq.bass1_l, eq.samplerate);
-	eq.bass2_l.cutoff = low_mid_crossover;
-	butterworth_biquad_coeffs(eq.bass2_l, eq.samplerate);
-	eq.bass1_r.cutoff = low_mid_crossover;
-	butterworth_biquad_coeffs(eq.bass1_r, eq.samplerate);
-	eq.bass2_r.cutoff = low_mid_crossover;
-	butterworth_biquad_coeffs(eq.bass2_r, eq.samplerate);
+	butterworth* filters[] = {&eq.mid_lp1_l, &eq.mid_lp2_l, &eq.mid_lp1_r, &eq.mid_lp2_r,
+							  &eq.treble1_l, &eq.treble2_l, &eq.treble1_r, &eq.treble2_r};
+	for (butterworth* f : filters) {
+		f->cutoff = crossover;
+		butterworth_biquad_coeffs(*f, eq.samplerate);
+	}
+}
 
-	eq.mid_hp1_l.cutoff = low_mid_crossover;
-	butterworth_biquad_coeffs(eq.mid_hp1_l, eq.samplerate);
-	eq.mid_hp2_l.cutoff = low_mid_crossover;
-	butterworth_biquad_coeffs(eq.mid_hp2_l, eq.samplerate);
-	eq.mid_lp1_l.cutoff = mid_high_crossover;
-	butterworth_biquad_coeffs(eq.mid_lp1_l, eq.samplerate);
-	eq.mid_lp2_l.cutoff = mid_high_crossover;
-	butterworth_biquad_coeffs(eq.mid_lp2_l, eq.samplerate);
+// sets all parameters at once, the gains change immediately
+inline void spliteq_update(spliteq& eq, double hp_freq, double lp_freq,
+						   double low_mid_crossover, double mid_high_crossover,
+						   double bass_gain, double mid_gain, double treble_gain)
+{
+	eq.update_params[SPLITEQ_HP_FREQ] = hp_freq;
+	eq.update_params[SPLITEQ_LP_FREQ] = lp_freq;
+	eq.update_params[SPLITEQ_LOW_MID_CROSSOVER] = low_mid_crossover;
+	eq.update_params[SPLITEQ_MID_HIGH_CROSSOVER] = mid_high_crossover;
+	eq.update_params[SPLITEQ_BASS_GAIN] = bass_gain;
+	eq.update_params[SPLITEQ_MID_GAIN] = mid_gain;
+	eq.update_params[SPLITEQ_TREBLE_GAIN] = treble_gain;
+
+	float gains[SPLITEQ_GAINS];
+	spliteq_linear_gains(eq, gains);
+	spliteq_set_gains(eq, gains);
 
-	eq.mid_hp1_r.cutoff = low_mid_crossover;
-	butterworth_biquad_coeffs(eq.mid_hp1_r, eq.samplerate);
-	eq.mid_hp2_r.cutoff = low_mid_crossover;
-	butterworth_biquad_coeffs(eq.mid_hp2_r, eq.samplerate);
-	eq.mid_lp1_r.cutoff = mid_high_crossover;
-	butterworth_biquad_coeffs(eq.mid_lp1_r, eq.samplerate);
-	eq.mid_lp2_r.cutoff = mid_high_crossover;
-	butterworth_biquad_coeffs(eq.mid_lp2_r, eq.samplerate);
+	eq.hp_l.amount = hp_freq;
+	eq.hp_r.amount = hp_freq;
+	eq.lp_l.amount = lp_freq;
+	eq.lp_r.amount = lp_freq;
 
-	eq.treble1_l.cutoff = mid_high_crossover;
-	butterworth_biquad_coeffs(eq.treble1_l, eq.samplerate);
-	eq.treble2_l.cutoff = mid_high_crossover;
-	butterworth_biquad_coeffs(eq.treble2_l, eq.samplerate);
-	eq.treble1_r.cutoff = mid_high_crossover;
-	butterworth_biquad_coeffs(eq.treble1_r, eq.samplerate);
-	eq.treble2_r.cutoff = mid_high_crossover;
-	butterworth_biquad_coeffs(eq.treble2_r, eq.samplerate);
+	spliteq_update_low_mid(eq);
+	spliteq_update_mid_high(eq);
 }
 
 inline void spliteq_update(spliteq& eq, double bass_gain, double mid_gain,
@@ -610,4 +759,69 @@ inline void spliteq_update(spliteq& eq, double bass_gain, double mid_gain,
 	trnr::spliteq_update(eq, eq.hp_l.amount, eq.lp_l.amount, eq.low_mid_crossover * 2.0,
 						 eq.mid_high_crossover * 2.0, bass_gain, mid_gain, treble_gain);
 }
+
+// Changes one spliteq_update argument and keeps the others, SPLITEQ_MODE takes a
+// spliteq_mode. Only the coefficients that depend on it are recalculated, gains ramp
+// over SPLITEQ_GAIN_RAMP_MS. Realtime safe.
+inline void spliteq_set_param(spliteq& eq, spliteq_param param, double value)
+{
+	if (param == SPLITEQ_MODE) {
+		spliteq_set_mode(eq, (spliteq_mode)(int)value);
+		return;
+	}
+
+	eq.update_params[param] = value;
+	float gains[SPLITEQ_GAINS];
+
+	switch (param) {
+	case SPLITEQ_HP_FREQ:
+		eq.hp_l.amount = value;
+		eq.hp_r.amount = value;
+		break;
+	case SPLITEQ_LP_FREQ:
+		eq.lp_l.amount = value;
+		eq.lp_r.amount = value;
+		break;
+	case SPLITEQ_LOW_MID_CROSSOVER:
+		spliteq_update_low_mid(eq);
+		break;
+	case SPLITEQ_MID_HIGH_CROSSOVER:
+		spliteq_update_mid_high(eq);
+		break;
+	case SPLITEQ_BASS_GAIN:
+		spliteq_update_low_mid(eq);
+		spliteq_linear_gains(eq, gains);
+		spliteq_ramp_gains(eq, gains);
+		break;
+	case SPLITEQ_MID_GAIN:
+		spliteq_linear_gains(eq, gains);
+		spliteq_ramp_gains(eq, gains);
+		break;
+	case SPLITEQ_TREBLE_GAIN:
+		spliteq_update_mid_high(eq);
+		spliteq_linear_gains(eq, gains);
+		spliteq_ramp_gains(eq, gains);
+		break;
+	default:
+		break;
+	}
+}
+
+// spliteq_process_block with sample accurate automation, the event params are
+// spliteq_param
+inline void spliteq_process_block_events(spliteq& eq, float** audio, int frames,
+										 param_queue& q)
+{
+	auto view = audio_buffer_view_of<2>(audio, frames);
+
+	param_queue_render(
+		q, frames,
+		[&](int offset, int len) {
+			auto sub = audio_buffer_view_frames(view, offset, len);
+			spliteq_process_block(eq, sub.channel_ptrs, len);
+		},
+		[&](int param, float value) {
+			spliteq_set_param(eq, (spliteq_param)param, value);
+		});
+}
 } // namespace trnr
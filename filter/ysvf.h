@@ -37,6 +37,8 @@
 #pragma once
 
 #define _USE_MATH_DEFINES
+#include "../util/param_queue.h"
+#include "../util/random.h"
 #include <array>
 #include <math.h>
 #include <stdint.h>
@@ -141,10 +143,8 @@ inline void ylowpass_init(ylowpass& y, double samplerate)
 		y.fixB[x] = 0.0;
 	}
 
-	y.fpdL = 1.0;
-	while (y.fpdL < 16386) y.fpdL = rand() * UINT32_MAX;
-	y.fpdR = 1.0;
-	while (y.fpdR < 16386) y.fpdR = rand() * UINT32_MAX;
+	y.fpdL = prng_fpd_seed();
+	y.fpdR = prng_fpd_seed();
 }
 
 template <typename t_sample>
@@ -209,8 +209,10 @@ inline void ylowpass_process_block(ylowpass& y, t_sample** inputs, t_sample** ou
 	for (int s = 0; s < blockSize; s++) {
 		double inputSampleL = *in1;
 		double inputSampleR = *in2;
+#ifndef TRNR_ASSUME_FTZ
 		if (fabs(inputSampleL) < 1.18e-23) inputSampleL = y.fpdL * 1.18e-17;
 		if (fabs(inputSampleR) < 1.18e-23) inputSampleR = y.fpdR * 1.18e-17;
+#endif
 		double drySampleL = inputSampleL;
 		double drySampleR = inputSampleR;
 
@@ -388,10 +390,8 @@ inline void yhighpass_init(yhighpass& y, double samplerate)
 		y.fixB[x] = 0.0;
 	}
 
-	y.fpdL = 1.0;
-	while (y.fpdL < 16386) y.fpdL = rand() * UINT32_MAX;
-	y.fpdR = 1.0;
-	while (y.fpdR < 16386) y.fpdR = rand() * UINT32_MAX;
+	y.fpdL = prng_fpd_seed();
+	y.fpdR = prng_fpd_seed();
 }
 
 template <typename t_sample>
@@ -456,8 +456,10 @@ inline void yhighpass_process_block(yhighpass& y, t_sample** inputs, t_sample**
 	for (int s = 0; s < blockSize; s++) {
 		double inputSampleL = *in1;
 		double inputSampleR = *in2;
+#ifndef TRNR_ASSUME_FTZ
 		if (fabs(inputSampleL) < 1.18e-23) inputSampleL = y.fpdL * 1.18e-17;
 		if (fabs(inputSampleR) < 1.18e-23) inputSampleR = y.fpdR * 1.18e-17;
+#endif
 		double drySampleL = inputSampleL;
 		double drySampleR = inputSampleR;
 
@@ -636,10 +638,8 @@ inline void ybandpass_init(ybandpass& y, double samplerate)
 		y.fixB[x] = 0.0;
 	}
 
-	y.fpdL = 1.0;
-	while (y.fpdL < 16386) y.fpdL = rand() * UINT32_MAX;
-	y.fpdR = 1.0;
-	while (y.fpdR < 16386) y.fpdR = rand() * UINT32_MAX;
+	y.fpdL = prng_fpd_seed();
+	y.fpdR = prng_fpd_seed();
 }
 
 template <typename t_sample>
@@ -705,8 +705,10 @@ inline void ybandpass_process_block(ybandpass& y, t_sample** inputs, t_sample**
 	for (int s = 0; s < blockSize; s++) {
 		double inputSampleL = *in1;
 		double inputSampleR = *in2;
+#ifndef TRNR_ASSUME_FTZ
 		if (fabs(inputSampleL) < 1.18e-23) inputSampleL = y.fpdL * 1.18e-17;
 		if (fabs(inputSampleR) < 1.18e-23) inputSampleR = y.fpdR * 1.18e-17;
+#endif
 		double drySampleL = inputSampleL;
 		double drySampleR = inputSampleR;
 
@@ -881,10 +883,8 @@ inline void ynotch_init(ynotch& y, double samplerate)
 		y.fixB[x] = 0.0;
 	}
 
-	y.fpdL = 1.0;
-	while (y.fpdL < 16386) y.fpdL = rand() * UINT32_MAX;
-	y.fpdR = 1.0;
-	while (y.fpdR < 16386) y.fpdR = rand() * UINT32_MAX;
+	y.fpdL = prng_fpd_seed();
+	y.fpdR = prng_fpd_seed();
 }
 
 template <typename t_sample>
@@ -949,8 +949,10 @@ inline void ynotch_process_block(ynotch& y, t_sample** inputs, t_sample** output
 	for (int s = 0; s < blockSize; s++) {
 		double inputSampleL = *in1;
 		double inputSampleR = *in2;
+#ifndef TRNR_ASSUME_FTZ
 		if (fabs(inputSampleL) < 1.18e-23) inputSampleL = y.fpdL * 1.18e-17;
 		if (fabs(inputSampleR) < 1.18e-23) inputSampleR = y.fpdR * 1.18e-17;
+#endif
 		double drySampleL = inputSampleL;
 		double drySampleR = inputSampleR;
 
@@ -1109,6 +1111,18 @@ inline void ysvf_init(ysvf& y, double samplerate = 44100)
 	y.filter_type = ysvf_types::Y_LOWPASS;
 }
 
+// the dither of every filter is seeded differently on init, a fixed seed makes the
+// output repeatable
+inline void ysvf_seed(ysvf& y, uint32_t seed)
+{
+	prng r;
+	prng_init(r, seed);
+	for (uint32_t* fpd : {&y.lowpass.fpdL, &y.lowpass.fpdR, &y.highpass.fpdL,
+						  &y.highpass.fpdR, &y.bandpass.fpdL, &y.bandpass.fpdR,
+						  &y.notch.fpdL, &y.notch.fpdR})
+		*fpd = prng_fpd_seed(r);
+}
+
 inline void ysvf_set_param(ysvf& y, ysvf_parameters param, float value)
 {
 	switch (param) {
@@ -1158,4 +1172,26 @@ inline void ysvf_process_samples(ysvf& y, t_sample** inputs, t_sample** outputs,
 		break;
 	}
 }
+
+// ysvf_process_samples with sample accurate automation, the event params are
+// ysvf_parameters. The filters interpolate their coefficients over every sub-block, so
+// a change ramps in from its event on.
+template <typename t_sample>
+inline void ysvf_process_block_events(ysvf& y, t_sample** inputs, t_sample** outputs,
+									  int block_size, param_queue& q)
+{
+	auto input_view = audio_buffer_view_of<2>(inputs, block_size);
+	auto output_view = audio_buffer_view_of<2>(outputs, block_size);
+
+	param_queue_render(
+		q, block_size,
+		[&](int offset, int len) {
+			auto in = audio_buffer_view_frames(input_view, offset, len);
+			auto out = audio_buffer_view_frames(output_view, offset, len);
+			ysvf_process_samples(y, in.channel_ptrs, out.channel_ptrs, len);
+		},
+		[&](int param, float value) {
+			ysvf_set_param(y, (ysvf_parameters)param, value);
+		});
+}
 } // namespace trnr
@@ -23,25 +23,19 @@
 
 #pragma once
 
-#include <array>
-#include <vector>
-
 #include "../filter/chebyshev.h"
+#include "../util/arena.h"
 
 namespace trnr {
+// largest block upsample takes without allocating, unless init is given another one
+constexpr int OVERSAMPLER_MAX_BLOCK_SIZE = 4096;
 
 template <typename sample>
 class oversampler {
 public:
-	oversampler()
-	{
-		buffer[0].reserve(num_samples);
-		buffer[1].reserve(num_samples);
-	}
-
-	~oversampler() { delete[] ptrs; }
-
-	void init(double _samplerate, int _ratio)
+	// the upsampled buffers are allocated here, for blocks up to _max_blocksize
+	void init(double _samplerate, int _ratio,
+			  int _max_blocksize = OVERSAMPLER_MAX_BLOCK_SIZE)
 	{
 		samplerate = _samplerate * _ratio;
 
@@ -53,60 +47,61 @@ public:
 		lowpass_out2.reset(samplerate, filter_freq);
 
 		ratio = _ratio;
+		reserve(_max_blocksize);
 	}
 
 	sample** upsample(sample** _inputs, int _blocksize)
 	{
+		// larger blocks than init was told about allocate on the audio thread
+		if (_blocksize > max_blocksize) reserve(_blocksize);
+
 		num_samples = _blocksize;
 		required_blocksize = _blocksize * ratio;
 
-		if (required_blocksize > current_blocksize) {
-			// resize buffer
-			buffer[0].resize(required_blocksize);
-			buffer[1].resize(required_blocksize);
-
-			current_blocksize = required_blocksize;
-		}
+		arena_reset(scratch);
+		buffer = arena_alloc_view<sample>(scratch, 2, required_blocksize);
+		sample* left = buffer.channel_ptrs[0];
+		sample* right = buffer.channel_ptrs[1];
 
 		for (int i = 0; i < _blocksize; ++i) {
 			const int adjusted_index = i * ratio;
 
-			buffer[0][adjusted_index] = _inputs[0][i];
-			buffer[1][adjusted_index] = _inputs[1][i];
+			left[adjusted_index] = _inputs[0][i];
+			right[adjusted_index] = _inputs[1][i];
 
 			for (int j = 1; j < ratio; ++j) {
-				buffer[0][adjusted_index + j] = 0.0f;
-				buffer[1][adjusted_index + j] = 0.0f;
+				left[adjusted_index + j] = 0.0f;
+				right[adjusted_index + j] = 0.0f;
 			}
 		}
 
 		if (ratio > 1) {
-			lowpass_in1.process_block(buffer[0].data(), required_blocksize);
-			lowpass_in2.process_block(buffer[1].data(), required_blocksize);
+			lowpass_in1.process_block(left, required_blocksize);
+			lowpass_in2.process_block(right, required_blocksize);
 
 			// compensate volume loss
 			for (int i = 0; i < required_blocksize; ++i) {
-				buffer[0][i] *= ratio;
-				buffer[1][i] *= ratio;
+				left[i] *= ratio;
+				right[i] *= ratio;
 			}
 		}
 
-		ptrs[0] = buffer[0].data();
-		ptrs[1] = buffer[1].data();
-
-		return ptrs;
+		return buffer.channel_ptrs;
 	}
 
 	void downsample(sample** _outputs)
 	{
+		sample* left = buffer.channel_ptrs[0];
+		sample* right = buffer.channel_ptrs[1];
+
 		if (ratio > 1) {
-			lowpass_out1.process_block(buffer[0].data(), required_blocksize);
-			lowpass_out2.process_block(buffer[1].data(), required_blocksize);
+			lowpass_out1.process_block(left, required_blocksize);
+			lowpass_out2.process_block(right, required_blocksize);
 		}
 
 		for (int i = 0; i < num_samples; ++i) {
-			_outputs[0][i] = buffer[0][i * ratio];
-			_outputs[1][i] = buffer[1][i * ratio];
+			_outputs[0][i] = left[i * ratio];
+			_outputs[1][i] = right[i * ratio];
 		}
 	}
 
@@ -117,7 +112,7 @@ private:
 
 	float filter_freq = 20000.f;
 
-	int current_blocksize = num_samples;
+	int max_blocksize = 0;
 	int required_blocksize = num_samples;
 
 	chebyshev lowpass_in1 {samplerate, 20000};
@@ -125,7 +120,15 @@ private:
 	chebyshev lowpass_out1 {samplerate, 20000};
 	chebyshev lowpass_out2 {samplerate, 20000};
 
-	std::array<std::vector<sample>, 2> buffer;
-	sample** ptrs = new sample*[2];
+	// holds the two upsampled channels of the current block
+	arena scratch;
+	audio_buffer_view<sample> buffer {};
+
+	void reserve(int _max_blocksize)
+	{
+		max_blocksize = _max_blocksize;
+		size_t channel_bytes = (size_t)max_blocksize * ratio * sizeof(sample);
+		arena_init(scratch, 2 * arena_align(channel_bytes));
+	}
 };
 } // namespace trnr
@@ -23,8 +23,8 @@
 
 #pragma once
 
+#include "../util/random.h"
 #include <cstddef>
-#include <cstdlib>
 #include <vector>
 
 using namespace std;
@@ -44,6 +44,7 @@ struct simple_seq {
 	playback_dir playback_dir;
 	vector<int> data;
 	bool pendulum_forward;
+	prng random;
 };
 
 inline void simple_seq_init(simple_seq& s, size_t length)
@@ -54,6 +55,7 @@ inline void simple_seq_init(simple_seq& s, size_t length)
 	s.data.resize(s.length);
 	s.data.assign(s.length, 0);
 	s.pendulum_forward = true;
+	prng_init(s.random, prng_unique_seed());
 }
 
 inline int simple_seq_process_step(simple_seq& s)
@@ -65,7 +67,8 @@ inline int simple_seq_process_step(simple_seq& s)
 	else if (s.playback_dir == PB_BACKWARD ||
 			 s.playback_dir == PB_PENDULUM && !s.pendulum_forward)
 		s.current_pos--;
-	else if (s.playback_dir == PB_RANDOM) s.current_pos = rand() % s.length;
+	else if (s.playback_dir == PB_RANDOM)
+		s.current_pos = prng_below(s.random, (uint32_t)s.length);
 
 	// play head reset
 	switch (s.playback_dir) {
@@ -25,9 +25,9 @@
 
 #include "../util/audio_buffer.h"
 #include "../util/audio_math.h"
+#include "../util/random.h"
 #include "voice_allocator.h"
 #include <cmath>
-#include <random>
 
 namespace trnr {
 
@@ -41,16 +41,22 @@ struct tx_sineosc {
 	float phase_resolution;
 	float phase;
 	float history;
+	prng random;
 };
 
+inline void tx_randomize_phase(prng& r, float& phase) { phase = prng_uniform(r); }
+
+// the signature before the oscillators had their own prng, draws from a new generator
+// on every call
 inline void tx_randomize_phase(float& phase)
 {
-	std::random_device random;
-	std::mt19937 gen(random());
-	std::uniform_real_distribution<> dis(0.0, 1.0);
-	phase = dis(gen);
+	prng r;
+	prng_init(r, prng_unique_seed());
+	tx_randomize_phase(r, phase);
 }
 
+inline void tx_randomize_phase(tx_sineosc& s) { tx_randomize_phase(s.random, s.phase); }
+
 inline void tx_sineosc_init(tx_sineosc& s, double samplerate)
 {
 	s.phase_reset = false;
@@ -59,7 +65,8 @@ inline void tx_sineosc_init(tx_sineosc& s, double samplerate)
 	s.phase = 0.f;
 	s.history = 0.f;
 
-	tx_randomize_phase(s.phase);
+	prng_init(s.random, prng_unique_seed());
+	tx_randomize_phase(s);
 }
 
 inline float tx_wrap(float& phase)
@@ -74,7 +81,7 @@ inline float tx_sineosc_process_sample(tx_sineosc& s, bool trigger, float freque
 {
 	if (trigger) {
 		if (s.phase_reset) s.phase = 0.f;
-		else tx_randomize_phase(s.phase);
+		else tx_randomize_phase(s);
 	}
 
 	float lookup_phase = s.phase + phase_modulation;
@@ -0,0 +1,205 @@
+/*
+ * golden.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../util/random.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+namespace trnr {
+
+/////////////
+// SIGNALS //
+/////////////
+
+// reference inputs for regression renders, the same for every run and platform
+enum golden_signal {
+	GOLDEN_SWEEP,	// exponential sine sweep from 20 Hz to 0.9 * nyquist at -6 dBFS
+	GOLDEN_IMPULSE, // unit impulses every 100 ms, the decays show the state of a module
+	GOLDEN_NOISE,	// white noise at -6 dBFS, different for every channel
+	GOLDEN_SIGNALS
+};
+
+inline const char* golden_signal_name(golden_signal signal)
+{
+	switch (signal) {
+	case GOLDEN_SWEEP:
+		return "sweep";
+	case GOLDEN_IMPULSE:
+		return "impulse";
+	case GOLDEN_NOISE:
+		return "noise";
+	default:
+		return "";
+	}
+}
+
+inline void golden_generate(golden_signal signal, float* out, size_t frames,
+							double samplerate, int channel)
+{
+	switch (signal) {
+	case GOLDEN_SWEEP: {
+		const double start = 20.0;
+		const double end = 0.45 * samplerate;
+		const double duration = frames / samplerate;
+		const double k = log(end / start);
+		const double scale = 2.0 * M_PI * start * duration / k;
+		for (size_t i = 0; i < frames; ++i) {
+			double t = i / samplerate;
+			out[i] = 0.5f * (float)sin(scale * (exp(t * k / duration) - 1.0));
+		}
+		break;
+	}
+	case GOLDEN_IMPULSE: {
+		size_t period = (size_t)(0.1 * samplerate);
+		for (size_t i = 0; i < frames; ++i) out[i] = i % period == 0 ? 1.f : 0.f;
+		break;
+	}
+	case GOLDEN_NOISE: {
+		prng random;
+		prng_init(random, 1 + channel);
+		for (size_t i = 0; i < frames; ++i) out[i] = 0.5f * prng_bipolar(random);
+		break;
+	}
+	default:
+		for (size_t i = 0; i < frames; ++i) out[i] = 0.f;
+		break;
+	}
+}
+
+/////////////
+// COMPARE //
+/////////////
+
+// frames of the spectral comparison, hann windowed with 50% overlap
+constexpr int GOLDEN_FFT_SIZE = 1024;
+
+inline double golden_max_abs_error(const float* reference, const float* output, size_t n)
+{
+	double error = 0.0;
+	for (size_t i = 0; i < n; ++i) {
+		double e = std::fabs((double)reference[i] - output[i]);
+		// a nan sticks and fails every tolerance
+		if (e > error || e != e) error = e;
+	}
+	return error;
+}
+
+// in place radix-2, the size has to be a power of two
+inline void golden_fft(std::vector<std::complex<double>>& x)
+{
+	const size_t n = x.size();
+
+	for (size_t i = 1, j = 0; i < n; ++i) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j) std::swap(x[i], x[j]);
+	}
+
+	for (size_t len = 2; len <= n; len <<= 1) {
+		std::complex<double> step = std::polar(1.0, -2.0 * M_PI / len);
+		for (size_t i = 0; i < n; i += len) {
+			std::complex<double> w = 1.0;
+			for (size_t k = 0; k < len / 2; ++k) {
+				std::complex<double> even = x[i + k];
+				std::complex<double> odd = x[i + k + len / 2] * w;
+				x[i + k] = even + odd;
+				x[i + k + len / 2] = even - odd;
+				w *= step;
+			}
+		}
+	}
+}
+
+// Energy of the difference of the magnitude spectra relative to the energy of the
+// reference spectrum, in dB. Ignores phase, so it accepts modules that are equivalent but
+// not sample aligned (random phases, jitter, dither). -inf for identical spectra.
+inline double golden_spectral_error_db(const float* reference, const float* output,
+									   size_t n)
+{
+	const int size = GOLDEN_FFT_SIZE;
+	std::vector<std::complex<double>> a(size), b(size);
+	double error = 0.0;
+	double energy = 0.0;
+
+	for (size_t start = 0; start + size <= n; start += size / 2) {
+		for (int i = 0; i < size; ++i) {
+			double window = 0.5 - 0.5 * cos(2.0 * M_PI * i / size);
+			a[i] = reference[start + i] * window;
+			b[i] = output[start + i] * window;
+		}
+		golden_fft(a);
+		golden_fft(b);
+
+		for (int i = 0; i <= size / 2; ++i) {
+			double difference = std::abs(a[i]) - std::abs(b[i]);
+			error += difference * difference;
+			energy += std::norm(a[i]);
+		}
+	}
+
+	if (error == 0.0) return -std::numeric_limits<double>::infinity();
+	if (energy == 0.0) return std::numeric_limits<double>::infinity();
+	return 10.0 * log10(error / energy);
+}
+
+// An output matches its golden render if it is within both limits. Bit exact is a max
+// abs error of 0, a limit of inf disables that check.
+struct golden_tolerance {
+	double max_abs = 0.0;
+	double spectral_db = std::numeric_limits<double>::infinity();
+};
+
+inline golden_tolerance golden_bit_exact() { return {}; }
+
+inline golden_tolerance golden_max_abs(double max_abs)
+{
+	return {max_abs, std::numeric_limits<double>::infinity()};
+}
+
+inline golden_tolerance golden_spectral(double spectral_db)
+{
+	return {std::numeric_limits<double>::infinity(), spectral_db};
+}
+
+struct golden_result {
+	double max_abs;
+	double spectral_db;
+	bool passed;
+};
+
+inline golden_result golden_compare(const golden_tolerance& t, const float* reference,
+									const float* output, size_t n)
+{
+	golden_result r;
+	r.max_abs = golden_max_abs_error(reference, output, n);
+	r.spectral_db = golden_spectral_error_db(reference, output, n);
+	r.passed = r.max_abs <= t.max_abs && r.spectral_db <= t.spectral_db;
+	return r;
+}
+} // namespace trnr
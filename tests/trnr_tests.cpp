@@ -0,0 +1,1041 @@
+/*
+ * trnr_tests.cpp
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Regression tests, run by ctest:
+//
+//   trnr-tests golden_dir             compares the renders with the golden files
+//   trnr-tests --render golden_dir    writes the golden files
+//
+// Renders: the golden signals (see golden.h) go through every module, stereo at 48 kHz
+// in blocks of 256 frames, and are compared with the files in golden_dir. Each module
+// has a tolerance, bit exact or a maximum absolute error; the error bounds leave room
+// for another libm or fma contraction, not for a change of the algorithm. Generators
+// (tx_synth, retro_buf, smoother) ignore the input and are rendered once. Golden files
+// are raw planar float32, little endian.
+//
+// Checks: every fast path against its reference (control rate against n = 1, tables
+// against the analytic curve, sse2 against scalar, block size independence), the
+// parameter event paths.
+//
+// Exits with 1 if anything fails or a golden file is missing.
+
+#include "../clip/adaa.h"
+#include "../clip/clip.h"
+#include "../clip/fold.h"
+#include "../clip/tube.h"
+#include "../companding/alaw.h"
+#include "../dynamics/limiter.h"
+#include "../dynamics/multiband.h"
+#include "../dynamics/oneknob.h"
+#include "../dynamics/pump.h"
+#include "../filter/chebyshev.h"
+#include "../filter/spliteq.h"
+#include "../filter/ysvf.h"
+#include "../oversampling/oversampler.h"
+#include "../synth/triplex.h"
+#include "../util/arena.h"
+#include "../util/audio_math.h"
+#include "../util/denormal.h"
+#include "../util/random.h"
+#include "../util/retro_buf.h"
+#include "../util/sample_format.h"
+#include "../util/smoother.h"
+#include "../util/waveshaper.h"
+#include "golden.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace trnr;
+
+constexpr double TEST_SAMPLERATE = 48000.0;
+constexpr int TEST_BLOCK_SIZE = 256;
+constexpr size_t TEST_FRAMES = 2048;
+
+// processes one stereo block in place, owns the state of the module
+using test_process = function<void(float** audio, int frames)>;
+
+using test_setup = function<test_process(double samplerate)>;
+
+struct test_render {
+	string module;
+	string variant;
+	test_setup setup;
+	golden_tolerance tolerance;
+	bool generator = false; // ignores the input
+};
+
+// prints the result line, returns 1 for a failure
+inline int test_report(bool passed, const string& name, const char* detail)
+{
+	fprintf(stderr, "%-4s %-40s %s\n", passed ? "ok" : "FAIL", name.c_str(), detail);
+	return passed ? 0 : 1;
+}
+
+/////////////
+// MODULES //
+/////////////
+
+inline test_process test_clip(double samplerate)
+{
+	auto s = make_shared<clip>();
+	clip_init(*s, samplerate);
+	return [s](float** a, int f) { clip_process_block(*s, a, a, f); };
+}
+
+// tube_amt sets the powerfactor, from 1 at full amount to 10 at none
+inline test_process test_tube(double samplerate, int powerfactor, bool adaa)
+{
+	auto s = make_shared<tube>();
+	tube_init(*s, samplerate);
+	tube_seed(*s, 1);
+	s->set_tube(1.0 - (powerfactor - 0.5) / 9.0);
+	s->adaa = adaa;
+	return [s](float** a, int f) { tube_process_block(*s, a, a, f); };
+}
+
+inline test_process test_hard_clip_adaa(double, float drive)
+{
+	auto s = make_shared<array<adaa_state, 2>>();
+	return [s, drive](float** a, int f) {
+		for (int ch = 0; ch < 2; ++ch) {
+			for (int i = 0; i < f; ++i) a[ch][i] *= drive;
+			adaa_hard_clip_block((*s)[ch], a[ch], f);
+		}
+	};
+}
+
+inline test_process test_fold(double, bool bipolar, float drive, bool adaa)
+{
+	auto s = make_shared<array<adaa_state, 2>>();
+	return [s, bipolar, drive, adaa](float** a, int f) {
+		for (int ch = 0; ch < 2; ++ch) {
+			float* audio = a[ch];
+			for (int i = 0; i < f; ++i) audio[i] *= drive;
+			if (adaa && bipolar) adaa_fold_bipolar_block((*s)[ch], audio, f);
+			else if (adaa) adaa_fold_block((*s)[ch], audio, f);
+			else if (bipolar) fold_bipolar_block(audio, f);
+			else fold_block(audio, f);
+		}
+	};
+}
+
+inline test_process test_waveshaper(double)
+{
+	auto w = make_shared<waveshaper>();
+	waveshaper_build(*w, [](double x) { return tanh(x); }, -4.f, 4.f);
+	return [w](float** a, int f) {
+		for (int ch = 0; ch < 2; ++ch) {
+			for (int i = 0; i < f; ++i) a[ch][i] *= 4.f;
+			waveshaper_process_block(*w, a[ch], f);
+		}
+	};
+}
+
+inline test_process test_alaw(double)
+{
+	return [](float** a, int f) {
+		for (int ch = 0; ch < 2; ++ch) {
+			alaw_encode_block(a[ch], f);
+			alaw_decode_block(a[ch], f);
+		}
+	};
+}
+
+inline test_process test_mulaw(double)
+{
+	return [](float** a, int f) {
+		for (int ch = 0; ch < 2; ++ch) {
+			mulaw_encode_block(a[ch], f);
+			mulaw_decode_block(a[ch], f);
+		}
+	};
+}
+
+inline test_process test_ysvf(double samplerate, ysvf_types type)
+{
+	auto y = make_shared<ysvf>();
+	ysvf_init(*y, samplerate);
+	ysvf_seed(*y, 1);
+	y->filter_type = type;
+	ysvf_set_param(*y, Y_FREQUENCY, 0.5f);
+	ysvf_set_param(*y, Y_RESONANCE, 0.5f);
+	return [y](float** a, int f) { ysvf_process_samples(*y, a, a, f); };
+}
+
+inline test_process test_spliteq(double samplerate, spliteq_mode mode)
+{
+	auto eq = make_shared<spliteq>();
+	spliteq_init(*eq, samplerate, 150.0, 1700.0);
+	spliteq_update(*eq, 0.0, 1.0, 150.0, 1700.0, 3.0, -2.0, 4.0);
+	eq->current_mode = eq->target_mode = mode;
+	return [eq](float** a, int f) { spliteq_process_block(*eq, a, f); };
+}
+
+inline test_process test_chebyshev(double samplerate)
+{
+	auto filters = make_shared<array<chebyshev, 2>>();
+	for (chebyshev& filter : *filters) filter.reset(samplerate, 8000.0);
+	return [filters](float** a, int f) {
+		for (int ch = 0; ch < 2; ++ch) (*filters)[ch].process_block(a[ch], f);
+	};
+}
+
+inline test_process test_oversampled_tube(double samplerate, int ratio)
+{
+	auto os = make_shared<oversampler<float>>();
+	os->init(samplerate, ratio);
+	test_process process = test_tube(samplerate * ratio, 5, false);
+	return [os, process, ratio](float** a, int f) {
+		float** up = os->upsample(a, f);
+		process(up, f * ratio);
+		os->downsample(a);
+	};
+}
+
+inline test_process test_pump(double samplerate, int control_rate, float attack_ms = 0.1f)
+{
+	auto p = make_shared<pump>();
+	pump_init(*p, samplerate);
+	pump_set_param(*p, PUMP_THRESHOLD, -20.f);
+	pump_set_param(*p, PUMP_RATIO, 4.f);
+	pump_set_param(*p, PUMP_ATTACK, attack_ms);
+	pump_set_control_rate(*p, control_rate);
+	return [p](float** a, int f) { pump_process_block(*p, a, a, f); };
+}
+
+inline test_process test_oneknob(double samplerate, int control_rate)
+{
+	auto o = make_shared<oneknob_comp>();
+	oneknob_init(*o, samplerate, 10.f);
+	o->amount = 0.5f;
+	oneknob_set_control_rate(*o, control_rate);
+	return [o](float** a, int f) { oneknob_process_block(*o, a, f); };
+}
+
+inline test_process test_limiter(double samplerate)
+{
+	auto l = make_shared<limiter>();
+	limiter_init(*l, samplerate);
+	limiter_set_param(*l, LIMITER_CEILING, -6.f);
+	return [l](float** a, int f) { limiter_process_block(*l, a, f); };
+}
+
+inline test_process test_multiband(double samplerate)
+{
+	auto mb = make_shared<multiband>();
+	multiband_init(*mb, samplerate);
+	for (int b = 0; b < MULTIBAND_BANDS; ++b) {
+		mb->bands[b].threshold_db = -20.f;
+		multiband_update_band(*mb, (multiband_band_index)b);
+	}
+	return [mb](float** a, int f) { multiband_process_block(*mb, a, f); };
+}
+
+// chords of four voices, a new one every 20 ms at sample accurate offsets
+struct test_tx_sequence {
+	tx_synth synth;
+	vector<midi_event> events;
+	long period;
+	long position = 0;
+	int root = -1;
+};
+
+inline void test_tx_events(test_tx_sequence& s, int frames)
+{
+	s.events.clear();
+
+	long next = (s.position + s.period - 1) / s.period * s.period;
+	for (; next < s.position + frames; next += s.period) {
+		int offset = (int)(next - s.position);
+		midi_event ev;
+		for (int i = 0; i < 4 && s.root >= 0; ++i) {
+			make_note_off(ev, s.root + i * 3, 0.f, offset);
+			s.events.push_back(ev);
+		}
+		s.root = s.root < 0 ? 48 : 48 + (s.root - 48 + 5) % 12;
+		for (int i = 0; i < 4; ++i) {
+			make_note_on(ev, s.root + i * 3, 1.f, offset);
+			s.events.push_back(ev);
+		}
+	}
+	s.position += frames;
+}
+
+inline test_process test_tx_synth(double samplerate)
+{
+	auto s = make_shared<test_tx_sequence>();
+	tx_synth_init(s->synth, samplerate);
+	s->synth.allocator.active_voice_count = 4;
+	for (tx_state& v : s->synth.voices) {
+		// no random start phases, no redux
+		v.bit_resolution = 24.f;
+		v.feedback_osc.phase_reset = true;
+		v.feedback_osc.phase_resolution = 4096.f;
+		for (tx_operator* op : {&v.op1, &v.op2, &v.op3}) {
+			op->oscillator.phase_reset = true;
+			op->oscillator.phase_resolution = 4096.f;
+			op->envelope.attack1_level = 1.f;
+			op->envelope.decay1_level = 0.7f;
+			op->envelope.sustain_level = 0.5f;
+		}
+	}
+	s->period = (long)(0.02 * samplerate);
+
+	return [s](float** a, int f) {
+		test_tx_events(*s, f);
+		tx_synth_process_block(s->synth, a, f, s->events);
+	};
+}
+
+inline test_process test_retro_buf(double samplerate)
+{
+	class sine_buf : public retro_buf {
+	public:
+		vector<float> data;
+		float get_sample(size_t index, size_t /*channel*/) override
+		{
+			return data[index];
+		}
+	};
+
+	auto r = make_shared<sine_buf>();
+	r->data.resize((size_t)samplerate / 10);
+	for (size_t i = 0; i < r->data.size(); ++i)
+		r->data[i] = 0.5f * sinf(2.f * (float)M_PI * 220.f * i / (float)samplerate);
+	r->set_host_samplerate(samplerate);
+	r->set_buf_samplerate(samplerate);
+	r->set_buffer_size(r->data.size());
+	r->set_channel_count(2);
+	r->set_seed(1);
+
+	auto out = make_shared<vector<double>>(2 * TEST_BLOCK_SIZE);
+	return [r, out](float** a, int f) {
+		retro_buf_modulation mod {};
+		mod.midi_note = 60.0;
+		mod.samplerate = 22050.0;
+		mod.bitrate = 8.0;
+		mod.end = r->data.size() - 1;
+		mod.looping = true;
+		mod.jitter = 2;
+
+		out->resize(2 * f);
+		double* outputs[2] = {out->data(), out->data() + f};
+		r->process_block(outputs, f, mod);
+		for (int ch = 0; ch < 2; ++ch)
+			for (int i = 0; i < f; ++i) a[ch][i] = (float)outputs[ch][i];
+	};
+}
+
+// a new target every 1000 frames
+inline test_process test_smoother(double samplerate)
+{
+	auto s = make_shared<array<smoother, 2>>();
+	for (smoother& sm : *s) smoother_init(sm, samplerate, 10.f);
+	auto position = make_shared<long>(0);
+
+	return [s, position](float** a, int f) {
+		for (int start = 0; start < f;) {
+			long next = (*position / 1000 + 1) * 1000;
+			int n = (int)min((long)(f - start), next - *position);
+			if (*position % 1000 == 0) {
+				float target = (*position / 1000) % 2 ? 0.25f : 1.f;
+				for (smoother& sm : *s) smoother_set_target(sm, target);
+			}
+			for (int ch = 0; ch < 2; ++ch)
+				smoother_process_block((*s)[ch], a[ch] + start, n);
+			start += n;
+			*position += n;
+		}
+	};
+}
+
+// planar to interleaved and back, with dither for int16
+inline test_process test_sample_format(double, sample_format format)
+{
+	size_t bytes = sample_format_bytes(format) * 2 * TEST_BLOCK_SIZE;
+	auto interleaved = make_shared<vector<unsigned char>>(bytes);
+	auto dither = make_shared<prng>();
+	prng_init(*dither, 1);
+
+	return [interleaved, dither, format](float** a, int f) {
+		interleave(a, interleaved->data(), format, 2, f, dither.get());
+		deinterleave(interleaved->data(), format, a, 2, f);
+	};
+}
+
+inline vector<test_render> test_renders()
+{
+	// libm and fma contraction differences stay well below these
+	const golden_tolerance curve = golden_max_abs(1e-5);
+	const golden_tolerance feedback = golden_max_abs(1e-4);
+	vector<test_render> renders;
+
+	renders.push_back({"clip", "default", test_clip, curve});
+	for (int pf : {1, 5, 10}) {
+		renders.push_back({"tube", "powerfactor_" + to_string(pf),
+						   [pf](double sr) { return test_tube(sr, pf, false); }, curve});
+	}
+	renders.push_back({"tube", "powerfactor_5_adaa",
+					   [](double sr) { return test_tube(sr, 5, true); }, curve});
+	renders.push_back({"tube", "powerfactor_5_os4",
+					   [](double sr) { return test_oversampled_tube(sr, 4); }, feedback});
+	renders.push_back({"hard_clip", "x4_adaa",
+					   [](double sr) { return test_hard_clip_adaa(sr, 4.f); }, curve});
+	renders.push_back({"fold", "closed_x3",
+					   [](double sr) { return test_fold(sr, false, 3.f, false); },
+					   curve});
+	renders.push_back({"fold", "bipolar_x5",
+					   [](double sr) { return test_fold(sr, true, 5.f, false); }, curve});
+	renders.push_back({"fold", "closed_x3_adaa",
+					   [](double sr) { return test_fold(sr, false, 3.f, true); }, curve});
+	renders.push_back({"waveshaper", "tanh", test_waveshaper, curve});
+	renders.push_back({"alaw", "roundtrip", test_alaw, curve});
+	renders.push_back({"mulaw", "roundtrip", test_mulaw, curve});
+
+	const char* types[] = {"lowpass", "highpass", "bandpass", "notch"};
+	for (int t = Y_LOWPASS; t <= Y_NOTCH; ++t) {
+		renders.push_back({"ysvf", types[t],
+						   [t](double sr) { return test_ysvf(sr, (ysvf_types)t); },
+						   feedback});
+	}
+	renders.push_back({"spliteq", "cascade_sum",
+					   [](double sr) { return test_spliteq(sr, CASCADE_SUM); },
+					   feedback});
+	renders.push_back({"spliteq", "linkwitz_riley",
+					   [](double sr) { return test_spliteq(sr, LINKWITZ_RILEY); },
+					   feedback});
+	renders.push_back({"chebyshev", "lowpass", test_chebyshev, feedback});
+
+	renders.push_back({"pump", "control_rate_1",
+					   [](double sr) { return test_pump(sr, 1); }, curve});
+	renders.push_back({"pump", "control_rate_16",
+					   [](double sr) { return test_pump(sr, 16); }, curve});
+	renders.push_back({"oneknob", "control_rate_1",
+					   [](double sr) { return test_oneknob(sr, 1); }, curve});
+	renders.push_back({"limiter", "default", test_limiter, curve});
+	renders.push_back({"multiband", "default", test_multiband, feedback});
+
+	// the oscillators of tx_synth peak at about -60 dBFS
+	renders.push_back({"tx_synth", "chords", test_tx_synth, golden_max_abs(1e-7), true});
+	renders.push_back({"retro_buf", "default", test_retro_buf, curve, true});
+	renders.push_back({"smoother", "steps", test_smoother, curve, true});
+	renders.push_back({"sample_format", "int16", [](double sr) {
+						   return test_sample_format(sr, SAMPLE_INT16);
+					   },
+					   golden_bit_exact()});
+	renders.push_back({"sample_format", "float32", [](double sr) {
+						   return test_sample_format(sr, SAMPLE_FLOAT32);
+					   },
+					   golden_bit_exact()});
+	return renders;
+}
+
+////////////
+// GOLDEN //
+////////////
+
+// renders signal through a new instance, out holds the channels one after the other
+inline void test_render_signal(const test_render& t, golden_signal signal, int block_size,
+							   vector<float>& out)
+{
+	test_process process = t.setup(TEST_SAMPLERATE);
+
+	const size_t frames = TEST_FRAMES;
+	out.assign(2 * frames, 0.f);
+	if (!t.generator) {
+		for (int ch = 0; ch < 2; ++ch)
+			golden_generate(signal, &out[ch * frames], frames, TEST_SAMPLERATE, ch);
+	}
+
+	for (size_t start = 0; start < frames; start += block_size) {
+		int n = (int)min((size_t)block_size, frames - start);
+		float* audio[2] = {&out[start], &out[frames + start]};
+		process(audio, n);
+	}
+}
+
+inline string test_golden_path(const string& dir, const test_render& t,
+							   golden_signal signal)
+{
+	string name = dir + "/" + t.module + "-" + t.variant;
+	if (!t.generator) name += string("-") + golden_signal_name(signal);
+	return name + ".f32";
+}
+
+inline bool test_golden_write(const string& path, const vector<float>& data)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) return false;
+	size_t written = fwrite(data.data(), sizeof(float), data.size(), file);
+	fclose(file);
+	return written == data.size();
+}
+
+// false if the file is missing or has another length
+inline bool test_golden_read(const string& path, vector<float>& data)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) return false;
+	size_t read = fread(data.data(), sizeof(float), data.size(), file);
+	bool end = fgetc(file) == EOF;
+	fclose(file);
+	return read == data.size() && end;
+}
+
+// worst result of the channels
+inline golden_result test_golden_compare(const test_render& t,
+										 const vector<float>& golden,
+										 const vector<float>& out)
+{
+	golden_result result {0.0, -numeric_limits<double>::infinity(), true};
+	for (int ch = 0; ch < 2; ++ch) {
+		size_t start = ch * TEST_FRAMES;
+		golden_result r =
+			golden_compare(t.tolerance, &golden[start], &out[start], TEST_FRAMES);
+		if (!(r.max_abs <= result.max_abs)) result.max_abs = r.max_abs;
+		if (!(r.spectral_db <= result.spectral_db)) result.spectral_db = r.spectral_db;
+		result.passed = result.passed && r.passed;
+	}
+	return result;
+}
+
+// returns the number of failures
+inline int test_golden(const string& dir, bool render)
+{
+	vector<float> out, golden;
+	int failed = 0;
+
+	for (const test_render& t : test_renders()) {
+		int signals = t.generator ? 1 : GOLDEN_SIGNALS;
+		for (int s = 0; s < signals; ++s) {
+			golden_signal signal = (golden_signal)s;
+			test_render_signal(t, signal, TEST_BLOCK_SIZE, out);
+			string path = test_golden_path(dir, t, signal);
+			string name = t.module + " " + t.variant;
+			if (!t.generator) name += string(" ") + golden_signal_name(signal);
+
+			if (render) {
+				if (!test_golden_write(path, out)) {
+					fprintf(stderr, "trnr-tests: cannot write %s\n", path.c_str());
+					return 1;
+				}
+				continue;
+			}
+
+			golden.assign(out.size(), 0.f);
+			if (!test_golden_read(path, golden)) {
+				failed += test_report(false, name, "no golden file");
+				continue;
+			}
+
+			golden_result r = test_golden_compare(t, golden, out);
+			char detail[64];
+			snprintf(detail, sizeof(detail), "max abs %.3g", r.max_abs);
+			failed += test_report(r.passed, name, detail);
+		}
+	}
+	return failed;
+}
+
+////////////
+// CHECKS //
+////////////
+
+// noise gated between full scale and -20 dB every 50 ms, keeps the gain computers moving
+inline vector<float> test_gated_noise(size_t frames, int channel)
+{
+	vector<float> signal(frames);
+	golden_generate(GOLDEN_NOISE, signal.data(), frames, TEST_SAMPLERATE, channel);
+	for (size_t i = 0; i < frames; ++i) signal[i] *= (i / 2400) % 2 ? 0.1f : 1.f;
+	return signal;
+}
+
+// renders gated noise in blocks, stereo planar
+inline vector<float> test_render_noise(test_process process, int block_size,
+									   size_t frames)
+{
+	vector<float> out(2 * frames);
+	for (int ch = 0; ch < 2; ++ch) {
+		vector<float> noise = test_gated_noise(frames, ch);
+		copy(noise.begin(), noise.end(), out.begin() + ch * frames);
+	}
+	for (size_t start = 0; start < frames; start += block_size) {
+		int n = (int)min((size_t)block_size, frames - start);
+		float* audio[2] = {&out[start], &out[frames + start]};
+		process(audio, n);
+	}
+	return out;
+}
+
+// the control rate gain ramps against the gain computer on every sample
+inline int test_control_rate()
+{
+	const size_t frames = 48000;
+	int failed = 0;
+
+	auto check = [&](const char* module, function<test_process(int)> make,
+					 double bound) {
+		vector<float> reference = test_render_noise(make(1), TEST_BLOCK_SIZE, frames);
+		for (int n : {4, 16, 32}) {
+			vector<float> out = test_render_noise(make(n), TEST_BLOCK_SIZE, frames);
+			double error = golden_max_abs_error(reference.data(), out.data(), out.size());
+			char name[64], detail[64];
+			snprintf(name, sizeof(name), "%s control rate %d", module, n);
+			snprintf(detail, sizeof(detail), "max abs %.3g (bound %.3g)", error, bound);
+			failed += test_report(error <= bound, name, detail);
+		}
+	};
+
+	// The gain lags the detector by up to 2n - 1 samples and pump detects the peak of
+	// the n samples, which reduces noise more than n = 1 does (up to ~1.6 dB here). The
+	// 0.1 ms default attack of pump follows single peaks, n > 1 is meant for attacks of a
+	// few ms.
+	check("pump", [](int n) { return test_pump(TEST_SAMPLERATE, n, 5.f); }, 0.12);
+	check("oneknob", [](int n) { return test_oneknob(TEST_SAMPLERATE, n); }, 0.02);
+	return failed;
+}
+
+// modules without block dependent ramps render the same in any block size
+inline int test_block_size()
+{
+	const size_t frames = 9600;
+	int failed = 0;
+
+	auto check = [&](const char* module, function<test_process()> make) {
+		vector<float> reference = test_render_noise(make(), TEST_BLOCK_SIZE, frames);
+		for (int block_size : {1, 37, 1024}) {
+			vector<float> out = test_render_noise(make(), block_size, frames);
+			bool differs =
+				memcmp(reference.data(), out.data(), out.size() * sizeof(float));
+			char name[64];
+			snprintf(name, sizeof(name), "%s block size %d", module, block_size);
+			failed += test_report(!differs, name, "bit exact to 256 frames");
+		}
+	};
+
+	check("clip", [] { return test_clip(TEST_SAMPLERATE); });
+	check("tube", [] { return test_tube(TEST_SAMPLERATE, 5, true); });
+	check("pump", [] { return test_pump(TEST_SAMPLERATE, 1); });
+	check("pump cr16", [] { return test_pump(TEST_SAMPLERATE, 16); });
+	check("oneknob cr16", [] { return test_oneknob(TEST_SAMPLERATE, 16); });
+	check("limiter", [] { return test_limiter(TEST_SAMPLERATE); });
+	check("multiband", [] { return test_multiband(TEST_SAMPLERATE); });
+	return failed;
+}
+
+// spliteq at the settings of test_spliteq
+inline void test_spliteq_init(spliteq& eq)
+{
+	spliteq_init(eq, TEST_SAMPLERATE, 150.0, 1700.0);
+	spliteq_update(eq, 0.0, 1.0, 150.0, 1700.0, 3.0, -2.0, 4.0);
+}
+
+// the *_process_block_events paths and spliteq_set_param
+inline int test_events()
+{
+	const size_t frames = 9600;
+	int failed = 0;
+	char detail[64];
+
+	// with an empty queue the events path renders like process_block
+	auto check = [&](const char* module, test_process reference, test_process events) {
+		vector<float> a = test_render_noise(reference, TEST_BLOCK_SIZE, frames);
+		vector<float> b = test_render_noise(events, TEST_BLOCK_SIZE, frames);
+		bool differs = memcmp(a.data(), b.data(), a.size() * sizeof(float));
+		char name[64];
+		snprintf(name, sizeof(name), "%s events", module);
+		failed += test_report(!differs, name, "bit exact to process_block");
+	};
+
+	auto q = make_shared<param_queue>();
+	auto p = make_shared<pump>();
+	pump_init(*p, TEST_SAMPLERATE);
+	pump_set_param(*p, PUMP_THRESHOLD, -20.f);
+	pump_set_param(*p, PUMP_RATIO, 4.f);
+	check("pump", test_pump(TEST_SAMPLERATE, 1), [p, q](float** a, int f) {
+		pump_process_block_events(*p, a, a, f, *q);
+	});
+
+	auto l = make_shared<limiter>();
+	limiter_init(*l, TEST_SAMPLERATE);
+	limiter_set_param(*l, LIMITER_CEILING, -6.f);
+	check("limiter", test_limiter(TEST_SAMPLERATE), [l, q](float** a, int f) {
+		limiter_process_block_events(*l, a, f, *q);
+	});
+
+	auto o = make_shared<oneknob_comp>();
+	oneknob_init(*o, TEST_SAMPLERATE, 10.f);
+	o->amount = 0.5f;
+	check("oneknob", test_oneknob(TEST_SAMPLERATE, 1), [o, q](float** a, int f) {
+		oneknob_process_block_events(*o, a, f, *q);
+	});
+
+	auto mb = make_shared<multiband>();
+	multiband_init(*mb, TEST_SAMPLERATE);
+	for (int b = 0; b < MULTIBAND_BANDS; ++b) {
+		mb->bands[b].threshold_db = -20.f;
+		multiband_update_band(*mb, (multiband_band_index)b);
+	}
+	check("multiband", test_multiband(TEST_SAMPLERATE), [mb, q](float** a, int f) {
+		multiband_process_block_events(*mb, a, f, *q);
+	});
+
+	auto eq = make_shared<spliteq>();
+	test_spliteq_init(*eq);
+	test_process eq_events = [eq, q](float** a, int f) {
+		spliteq_process_block_events(*eq, a, f, *q);
+	};
+	check("spliteq", test_spliteq(TEST_SAMPLERATE, CASCADE_SUM), eq_events);
+
+	// one meter snapshot per block, however many sub-blocks the events make
+	pump meter_pump;
+	pump_init(meter_pump, TEST_SAMPLERATE);
+	vector<float> noise = test_gated_noise(TEST_BLOCK_SIZE, 0);
+	float* audio[2] = {noise.data(), noise.data()};
+	for (int frame : {10, 100, 200}) param_queue_push(*q, frame, PUMP_THRESHOLD, -20.f);
+	pump_process_block_events(meter_pump, audio, audio, TEST_BLOCK_SIZE, *q);
+	dynamics_meter_values values;
+	bool once = dynamics_meter_read(meter_pump.meter, values) && values.block == 1;
+	failed += test_report(once, "pump events meter", "published once per block");
+
+	// set_param recalculates what spliteq_update would
+	spliteq updated, set;
+	test_spliteq_init(updated);
+	spliteq_init(set, TEST_SAMPLERATE, 150.0, 1700.0);
+	const double params[] = {0.0, 1.0, 150.0, 1700.0, 3.0, -2.0, 4.0};
+	for (int i = 0; i < SPLITEQ_UPDATE_PARAMS; ++i)
+		spliteq_set_param(set, (spliteq_param)i, params[i]);
+	vector<float> silence(TEST_SAMPLERATE / 10);
+	float* silent[2] = {silence.data(), silence.data()};
+	spliteq_process_block(set, silent, (int)silence.size());
+	bool same = !set.gains_ramping;
+	for (int g = 0; g < SPLITEQ_GAINS; ++g)
+		same = same && set.*SPLITEQ_GAIN_FIELDS[g] == updated.*SPLITEQ_GAIN_FIELDS[g];
+	same = same && set.bass_l.alpha == updated.bass_l.alpha &&
+		   set.treble_l.alpha == updated.treble_l.alpha &&
+		   set.mid_hp1_r.b0 == updated.mid_hp1_r.b0 &&
+		   set.treble2_r.b0 == updated.treble2_r.b0;
+	failed += test_report(same, "spliteq_set_param", "same gains and coefficients");
+
+	// a gain event ramps in instead of stepping: a 100 Hz sine with and without +12 dB
+	// bass from frame 1000, the difference moves by more than 0.3 in one frame if the
+	// gain steps
+	vector<float> sine[2];
+	for (vector<float>& signal : sine) {
+		signal.resize(4800);
+		for (size_t i = 0; i < signal.size(); ++i)
+			signal[i] = 0.5f * sin(2.0 * M_PI * 100.0 * i / TEST_SAMPLERATE);
+	}
+	for (int v = 0; v < 2; ++v) {
+		spliteq e;
+		test_spliteq_init(e);
+		if (v) param_queue_push(*q, 1000, SPLITEQ_BASS_GAIN, 12.f);
+		for (size_t start = 0; start < sine[v].size(); start += TEST_BLOCK_SIZE) {
+			float* block[2] = {&sine[v][start], &sine[v][start]};
+			int n = (int)min((size_t)TEST_BLOCK_SIZE, sine[v].size() - start);
+			spliteq_process_block_events(e, block, n, *q);
+		}
+	}
+	double jump = 0.0;
+	for (size_t i = 1; i < sine[0].size(); ++i) {
+		double d = (sine[1][i] - sine[0][i]) - (sine[1][i - 1] - sine[0][i - 1]);
+		jump = max(jump, fabs(d));
+	}
+	snprintf(detail, sizeof(detail), "max change %.3g per frame (bound 0.02)", jump);
+	failed += test_report(jump <= 0.02, "spliteq gain event", detail);
+	return failed;
+}
+
+// the tabulated curves against the curve they sample
+inline int test_tables()
+{
+	int failed = 0;
+	char detail[64];
+
+	waveshaper w;
+	waveshaper_build(w, [](double x) { return tanh(x); }, -4.f, 4.f);
+	double error = waveshaper_max_error(w, [](double x) { return tanh(x); });
+	snprintf(detail, sizeof(detail), "max abs %.3g (bound 1e-6)", error);
+	failed += test_report(error <= 1e-6, "waveshaper tanh table", detail);
+
+	// the sse2 block path reads the same table
+	vector<float> block(1027), scalar(1027);
+	for (size_t i = 0; i < block.size(); ++i) block[i] = -5.f + 10.f * i / block.size();
+	for (size_t i = 0; i < block.size(); ++i)
+		scalar[i] = waveshaper_process_sample(w, block[i]);
+	waveshaper_process_block(w, block.data(), (int)block.size());
+	error = golden_max_abs_error(scalar.data(), block.data(), block.size());
+	failed += test_report(error == 0.0, "waveshaper block", "bit exact to the samples");
+
+	// the adaa tables of tube against the curve they integrate: the mean over an interval
+	// (the adaa output) of a small interval is the curve in its middle
+	tube t;
+	tube_init(t, TEST_SAMPLERATE);
+	const adaa_table& table = t.adaa_curves[4];
+	error = 0.0;
+	for (double x = -1.2; x < 1.2; x += 0.001) {
+		double h = 1e-3;
+		double mean = (adaa_table_antiderivative(table, x + h) -
+					   adaa_table_antiderivative(table, x - h)) /
+					  (2.0 * h);
+		error = max(error, fabs(mean - tube_curve<5>(x)));
+	}
+	snprintf(detail, sizeof(detail), "max abs %.3g (bound 1e-3)", error);
+	failed += test_report(error <= 1e-3, "tube adaa table", detail);
+	return failed;
+}
+
+// the sse2 and block paths against their scalar reference
+inline int test_simd()
+{
+	int failed = 0;
+	const int n = 1027;
+
+	vector<float> input(n);
+	for (int i = 0; i < n; ++i) input[i] = -7.f + 14.f * i / n;
+
+	vector<float> block = input;
+	fold_block(block.data(), n);
+	bool same = true;
+	for (int i = 0; i < n; ++i) {
+		float x = input[i];
+		same = same && fold(x) == block[i];
+	}
+	failed += test_report(same, "fold block", "bit exact to fold");
+
+	block = input;
+	fold_bipolar_block(block.data(), n);
+	same = true;
+	for (int i = 0; i < n; ++i) {
+		float x = input[i];
+		same = same && fold_bipolar(x) == block[i];
+	}
+	failed += test_report(same, "fold_bipolar block", "bit exact to fold_bipolar");
+
+	// starts off lane 0 so the scalar head is used too
+	prng a, b;
+	prng_init(a, 7);
+	prng_init(b, 7);
+	prng_next(a);
+	prng_next(b);
+	prng_uniform_block(a, block.data(), n);
+	same = true;
+	for (int i = 0; i < n; ++i) same = same && prng_uniform(b) == block[i];
+	prng_bipolar_block(a, block.data(), n);
+	for (int i = 0; i < n; ++i) same = same && prng_bipolar(b) == block[i];
+	prng_tpdf_block(a, block.data(), n);
+	for (int i = 0; i < n; ++i) same = same && prng_tpdf(b) == block[i];
+	failed += test_report(same, "prng blocks", "bit exact to the scalar sequence");
+	return failed;
+}
+
+// the documented error bounds of the fast math functions and the blocks built on them
+inline int test_fast_math()
+{
+	int failed = 0;
+	char detail[64];
+
+	double error = 0.0;
+	for (double x = -30.0; x <= 30.0; x += 1e-3) {
+		double e = fabs(fast_exp2((float)x) / exp2((double)(float)x) - 1.0);
+		error = max(error, e);
+	}
+	snprintf(detail, sizeof(detail), "max relative %.3g (bound 4.2e-6)", error);
+	failed += test_report(error <= 4.2e-6, "fast_exp2", detail);
+
+	error = 0.0;
+	for (double x = 1e-30; x <= 1e30; x *= 1.0001) {
+		double e = fabs(fast_log2((float)x) - log2((double)(float)x));
+		error = max(error, e);
+	}
+	snprintf(detail, sizeof(detail), "max abs %.3g (bound 1.85e-5)", error);
+	failed += test_report(error <= 1.85e-5, "fast_log2", detail);
+
+	// the companding blocks against the std::log/std::exp curves, the length is not a
+	// multiple of four so the scalar tail is checked too. the decoders are relative to
+	// the exponential, the mu-law one is offset by 1 / mu.
+	struct companding_case {
+		const char* name;
+		void (*block)(float*, int);
+		float (*reference)(float);
+		bool relative;
+		double offset;
+		double bound;
+	};
+	const companding_case cases[] = {
+		{"alaw_encode_block", alaw_encode_block, alaw_encode, false, 0.0, 2.5e-6},
+		{"alaw_decode_block", alaw_decode_block, alaw_decode, true, 0.0, 4.5e-6},
+		{"mulaw_encode_block", mulaw_encode_block, mulaw_encode, false, 0.0, 2.5e-6},
+		{"mulaw_decode_block", mulaw_decode_block, mulaw_decode, true, MU_LAW_INV_MU,
+		 4.5e-6},
+	};
+	const int n = 200003;
+	vector<float> block(n);
+	for (const companding_case& c : cases) {
+		for (int i = 0; i < n; ++i) block[i] = -1.2f + 2.4f * i / (n - 1);
+		c.block(block.data(), n);
+		error = 0.0;
+		for (int i = 0; i < n; ++i) {
+			double reference = c.reference(-1.2f + 2.4f * i / (n - 1));
+			double e = fabs(block[i] - reference);
+			double magnitude = fabs(reference) + c.offset;
+			if (c.relative && magnitude != 0.0) e /= magnitude;
+			error = max(error, e);
+		}
+		snprintf(detail, sizeof(detail), "max %s %.3g (bound %.2g)",
+				 c.relative ? "relative" : "abs", error, c.bound);
+		failed += test_report(error <= c.bound, c.name, detail);
+	}
+	return failed;
+}
+
+// the guard flushes while in scope and restores the mode it found
+inline int test_denormal()
+{
+	if (DENORMAL_FLUSH_BITS == 0) {
+		fprintf(stderr, "%-4s %-40s %s\n", "skip", "denormal_guard", "no flush mode");
+		return 0;
+	}
+
+	int failed = 0;
+	uint64_t before = denormal_get_state();
+
+	// from flushing off and from flushing already on
+	for (bool flushing : {false, true}) {
+		uint64_t outer = flushing ? before | DENORMAL_FLUSH_BITS
+								  : before & ~DENORMAL_FLUSH_BITS;
+		denormal_set_state(outer);
+
+		bool inside;
+		{
+			denormal_guard guard;
+			inside = denormal_flushing();
+		}
+		bool restored = denormal_get_state() == outer;
+
+		const char* name = flushing ? "denormal_guard while flushing" : "denormal_guard";
+		failed += test_report(inside && restored, name, "flushes, restores the mode");
+	}
+
+	denormal_set_state(before);
+	return failed;
+}
+
+// advancing a smoother bank without writing the ramps ends where the written ramps end
+inline int test_smoother_bank()
+{
+	smoother_bank<4> advanced, written;
+	smoother_bank_init(advanced, TEST_SAMPLERATE, 1.f);
+	smoother_bank_init(written, TEST_SAMPLERATE, 1.f);
+
+	float ramps[4][64];
+	float* out[4] = {ramps[0], ramps[1], ramps[2], ramps[3]};
+
+	// mixed targets, one smoother left settled, steps shorter and longer than the ramp
+	// and a new target while the others are still moving
+	bool same = true;
+	const int steps[] = {7, 13, 1, 64, 5, 30, 64};
+	for (int step = 0; step < 7; ++step) {
+		if (step == 0 || step == 4) {
+			float sign = step == 0 ? 1.f : -1.f;
+			smoother_bank_set_target(advanced, 0, sign);
+			smoother_bank_set_target(written, 0, sign);
+			smoother_bank_set_target(advanced, 1, -0.5f * sign);
+			smoother_bank_set_target(written, 1, -0.5f * sign);
+		}
+		if (step == 2) {
+			smoother_bank_set_target(advanced, 3, 0.25f);
+			smoother_bank_set_target(written, 3, 0.25f);
+		}
+
+		int n = steps[step];
+		bool settled = smoother_bank_advance(advanced, n);
+		same = same && settled == smoother_bank_process_block(written, out, n);
+		for (size_t i = 0; i < 4; ++i) {
+			same = same && advanced.current[i] == written.current[i] &&
+				   advanced.remaining[i] == written.remaining[i];
+		}
+	}
+	return test_report(same, "smoother_bank_advance", "same values and settled flag");
+}
+
+// blocks in order, freed blocks first and last freed first, nullptr when full
+inline int test_pool()
+{
+	pool p;
+	pool_init(p, 24, 3);
+	unsigned char* base = p.memory.data();
+	size_t size = p.block_size;
+
+	void* a = pool_alloc(p);
+	void* b = pool_alloc(p);
+	bool order = a == base && b == base + size && size == arena_align(24);
+
+	pool_free(p, a);
+	pool_free(p, b);
+	bool reuse = pool_alloc(p) == b && pool_alloc(p) == a;
+
+	void* c = pool_alloc(p);
+	bool exhausted = c == base + 2 * size && pool_alloc(p) == nullptr;
+
+	pool_free(p, c);
+	pool_reset(p);
+	bool reset = pool_alloc(p) == base && pool_alloc(p) == base + size;
+
+	int failed = test_report(order, "pool alloc", "consecutive aligned blocks");
+	failed += test_report(reuse, "pool free", "freed blocks reused, last first");
+	failed += test_report(exhausted, "pool exhausted", "nullptr when all are in use");
+	failed += test_report(reset, "pool reset", "starts over at the first block");
+	return failed;
+}
+
+int main(int argc, char** argv)
+{
+	bool render = argc == 3 && string(argv[1]) == "--render";
+	if (argc != 2 && !render) {
+		fprintf(stderr, "usage: trnr-tests [--render] golden_dir\n");
+		return 1;
+	}
+	string dir = argv[argc - 1];
+
+	if (render) return test_golden(dir, true);
+
+	int failed = test_golden(dir, false);
+	failed += test_control_rate();
+	failed += test_block_size();
+	failed += test_events();
+	failed += test_tables();
+	failed += test_simd();
+	failed += test_fast_math();
+	failed += test_denormal();
+	failed += test_smoother_bank();
+	failed += test_pool();
+
+	fprintf(stderr, "%d failed\n", failed);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * arena.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "audio_buffer.h"
+#include <cstddef>
+
+// define TRNR_ARENA_DEBUG to track the high-water marks of arenas and pools
+
+namespace trnr {
+// scratch memory for the audio thread, only init allocates
+using arena_memory =
+	vector<unsigned char, aligned_allocator<unsigned char, AUDIO_BUFFER_ALIGNMENT>>;
+
+// rounds up to the next multiple of AUDIO_BUFFER_ALIGNMENT
+inline size_t arena_align(size_t bytes)
+{
+	return (bytes + AUDIO_BUFFER_ALIGNMENT - 1) & ~(AUDIO_BUFFER_ALIGNMENT - 1);
+}
+
+///////////
+// ARENA //
+///////////
+
+// Monotonic allocator: allocations bump an offset, arena_reset frees everything at once.
+// Reset it at the end of every block. All allocations are aligned like audio_buffer
+// channels.
+struct arena {
+	arena_memory memory;
+	size_t offset = 0;
+
+#ifdef TRNR_ARENA_DEBUG
+	size_t high_water = 0; // most bytes in use at once
+	size_t failed = 0;	   // allocations that did not fit
+#endif
+};
+
+inline void arena_init(arena& a, size_t bytes)
+{
+	a.memory.assign(bytes, 0);
+	a.offset = 0;
+#ifdef TRNR_ARENA_DEBUG
+	a.high_water = 0;
+	a.failed = 0;
+#endif
+}
+
+// nullptr if the arena is exhausted
+inline void* arena_alloc(arena& a, size_t bytes)
+{
+	size_t start = arena_align(a.offset);
+	if (start + bytes > a.memory.size()) {
+#ifdef TRNR_ARENA_DEBUG
+		a.failed++;
+#endif
+		return nullptr;
+	}
+
+	a.offset = start + bytes;
+#ifdef TRNR_ARENA_DEBUG
+	if (a.offset > a.high_water) a.high_water = a.offset;
+#endif
+	return a.memory.data() + start;
+}
+
+// uninitialized
+template <typename t>
+inline t* arena_alloc_array(arena& a, size_t count)
+{
+	return static_cast<t*>(arena_alloc(a, count * sizeof(t)));
+}
+
+// channels with aligned starts, zero channels if the arena is exhausted
+template <typename t_sample>
+inline audio_buffer_view<t_sample> arena_alloc_view(arena& a, size_t channels,
+													size_t frames)
+{
+	audio_buffer_view<t_sample> v;
+	v.channels = 0;
+	v.frames = frames;
+
+	if (channels > TRNR_AUDIO_BUFFER_MAX_CHANNELS) return v;
+
+	size_t mark = a.offset;
+	for (size_t ch = 0; ch < channels; ++ch) {
+		v.channel_ptrs[ch] = arena_alloc_array<t_sample>(a, frames);
+		if (!v.channel_ptrs[ch]) {
+			a.offset = mark;
+			return v;
+		}
+	}
+	v.channels = channels;
+	return v;
+}
+
+inline void arena_reset(arena& a) { a.offset = 0; }
+
+// arena_rewind to a mark frees everything allocated after it, for nested scratch use
+inline size_t arena_mark(const arena& a) { return a.offset; }
+
+inline void arena_rewind(arena& a, size_t mark) { a.offset = mark; }
+
+inline size_t arena_used(const arena& a) { return a.offset; }
+
+//////////
+// POOL //
+//////////
+
+// Fixed-size blocks with O(1) alloc, free and reset. Unused blocks are handed out in
+// order, freed blocks go to a free list that is kept inside the blocks themselves. Not
+// copyable, a copy's free list would point into the memory of the original.
+struct pool {
+	pool() = default;
+	pool(const pool&) = delete;
+	pool& operator=(const pool&) = delete;
+
+	arena_memory memory;
+	size_t block_size = 0;
+	size_t block_count = 0;
+	size_t next_unused = 0;
+	void* free_list = nullptr;
+
+#ifdef TRNR_ARENA_DEBUG
+	size_t in_use = 0;
+	size_t high_water = 0; // most blocks in use at once
+#endif
+};
+
+// block_size is rounded up to the alignment
+inline void pool_init(pool& p, size_t block_size, size_t block_count)
+{
+	if (block_size < sizeof(void*)) block_size = sizeof(void*);
+	p.block_size = arena_align(block_size);
+	p.block_count = block_count;
+	p.memory.assign(p.block_size * block_count, 0);
+	p.next_unused = 0;
+	p.free_list = nullptr;
+#ifdef TRNR_ARENA_DEBUG
+	p.in_use = 0;
+	p.high_water = 0;
+#endif
+}
+
+// nullptr if all blocks are in use
+inline void* pool_alloc(pool& p)
+{
+	void* block = nullptr;
+	if (p.free_list) {
+		block = p.free_list;
+		p.free_list = *static_cast<void**>(block);
+	} else if (p.next_unused < p.block_count) {
+		block = p.memory.data() + p.next_unused * p.block_size;
+		p.next_unused++;
+	}
+
+#ifdef TRNR_ARENA_DEBUG
+	if (block && ++p.in_use > p.high_water) p.high_water = p.in_use;
+#endif
+	return block;
+}
+
+inline void pool_free(pool& p, void* block)
+{
+	if (!block) return;
+	*static_cast<void**>(block) = p.free_list;
+	p.free_list = block;
+#ifdef TRNR_ARENA_DEBUG
+	p.in_use--;
+#endif
+}
+
+// returns all blocks at once
+inline void pool_reset(pool& p)
+{
+	p.next_unused = 0;
+	p.free_list = nullptr;
+#ifdef TRNR_ARENA_DEBUG
+	p.in_use = 0;
+#endif
+}
+} // namespace trnr
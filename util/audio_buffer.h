@@ -23,35 +23,196 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstddef>
+#include <new>
 #include <vector>
 
 using namespace std;
 
+// maximum number of channels an audio_buffer_view can reference
+#ifndef TRNR_AUDIO_BUFFER_MAX_CHANNELS
+#define TRNR_AUDIO_BUFFER_MAX_CHANNELS 16
+#endif
+
 namespace trnr {
+// channel starts are aligned to a cache line, which also covers every simd load width
+constexpr size_t AUDIO_BUFFER_ALIGNMENT = 64;
+
+template <typename t, size_t alignment>
+struct aligned_allocator {
+	using value_type = t;
+
+	template <typename u>
+	struct rebind {
+		using other = aligned_allocator<u, alignment>;
+	};
+
+	aligned_allocator() = default;
+
+	template <typename u>
+	aligned_allocator(const aligned_allocator<u, alignment>&)
+	{
+	}
+
+	t* allocate(size_t n)
+	{
+		return static_cast<t*>(::operator new(n * sizeof(t), align_val_t(alignment)));
+	}
+
+	void deallocate(t* p, size_t) { ::operator delete(p, align_val_t(alignment)); }
+};
+
+template <typename t, typename u, size_t alignment>
+bool operator==(const aligned_allocator<t, alignment>&,
+				const aligned_allocator<u, alignment>&)
+{
+	return true;
+}
+
+template <typename t, typename u, size_t alignment>
+bool operator!=(const aligned_allocator<t, alignment>&,
+				const aligned_allocator<u, alignment>&)
+{
+	return false;
+}
+
 template <typename t_sample>
 struct audio_buffer {
+	static_assert(AUDIO_BUFFER_ALIGNMENT % sizeof(t_sample) == 0,
+				  "sample size has to divide the alignment");
+
 	size_t channels;
 	size_t frames;
+	// frames after the end of each channel that simd loops may overrun into
+	size_t padding;
+	// samples from one channel start to the next, frames + padding rounded up to the
+	// alignment
+	size_t stride;
 
-	vector<t_sample> flat_data;
+	vector<t_sample, aligned_allocator<t_sample, AUDIO_BUFFER_ALIGNMENT>> flat_data;
 	vector<t_sample*> channel_ptrs;
 };
 
+// non-owning channel pointers into an audio_buffer or host buffers, cheap to copy. pass
+// channel_ptrs where modules take t_sample**.
+template <typename t_sample>
+struct audio_buffer_view {
+	size_t channels;
+	size_t frames;
+	t_sample* channel_ptrs[TRNR_AUDIO_BUFFER_MAX_CHANNELS];
+};
+
+template <typename t_sample>
+size_t audio_buffer_stride(size_t frames, size_t padding)
+{
+	const size_t align = AUDIO_BUFFER_ALIGNMENT / sizeof(t_sample);
+	return (frames + padding + align - 1) / align * align;
+}
+
+template <typename t_sample>
+void audio_buffer_update_ptrs(audio_buffer<t_sample>& a)
+{
+	for (size_t ch = 0; ch < a.channels; ++ch) {
+		a.channel_ptrs[ch] = a.flat_data.data() + ch * a.stride;
+	}
+}
+
+// allocates and clears the buffer
 template <typename t_sample>
-void audio_buffer_init(audio_buffer<t_sample>& a, size_t channels, size_t frames)
+void audio_buffer_init(audio_buffer<t_sample>& a, size_t channels, size_t frames,
+					   size_t padding = 0)
 {
 	a.channels = channels;
 	a.frames = frames;
-	a.flat_data.resize(channels * frames);
+	a.padding = padding;
+	a.stride = audio_buffer_stride<t_sample>(frames, padding);
+	a.flat_data.assign(channels * a.stride, t_sample(0));
 	a.channel_ptrs.resize(channels);
 	audio_buffer_update_ptrs(a);
 }
 
+// Changes the layout without giving memory back, so resizing within the largest size
+// so far never allocates. The contents are not kept.
 template <typename t_sample>
-void audio_buffer_update_ptrs(audio_buffer<t_sample>& a)
+void audio_buffer_resize(audio_buffer<t_sample>& a, size_t channels, size_t frames)
 {
-	for (int ch = 0; ch < a.channels; ++ch) {
-		a.channel_ptrs[ch] = a.flat_data.data() + ch * a.frames;
-	}
+	a.channels = channels;
+	a.frames = frames;
+	a.stride = audio_buffer_stride<t_sample>(frames, a.padding);
+	a.flat_data.resize(channels * a.stride);
+	a.channel_ptrs.resize(channels);
+	audio_buffer_update_ptrs(a);
+}
+
+template <typename t_sample>
+void audio_buffer_clear(audio_buffer<t_sample>& a)
+{
+	for (auto& sample : a.flat_data) sample = t_sample(0);
+}
+
+///////////
+// VIEWS //
+///////////
+
+// a view holds at most TRNR_AUDIO_BUFFER_MAX_CHANNELS channels, raise it for wider buses
+template <typename t_sample>
+audio_buffer_view<t_sample> audio_buffer_view_of(t_sample** channel_ptrs, size_t channels,
+												 size_t frames)
+{
+	assert(channels <= TRNR_AUDIO_BUFFER_MAX_CHANNELS &&
+		   "raise TRNR_AUDIO_BUFFER_MAX_CHANNELS");
+
+	audio_buffer_view<t_sample> v;
+	v.channels = channels;
+	v.frames = frames;
+	for (size_t ch = 0; ch < v.channels; ++ch) v.channel_ptrs[ch] = channel_ptrs[ch];
+	return v;
+}
+
+// for a channel count known at compile time
+template <size_t channels, typename t_sample>
+audio_buffer_view<t_sample> audio_buffer_view_of(t_sample** channel_ptrs, size_t frames)
+{
+	static_assert(channels <= TRNR_AUDIO_BUFFER_MAX_CHANNELS,
+				  "raise TRNR_AUDIO_BUFFER_MAX_CHANNELS");
+	return audio_buffer_view_of(channel_ptrs, channels, frames);
+}
+
+template <typename t_sample>
+audio_buffer_view<t_sample> audio_buffer_view_of(audio_buffer<t_sample>& a)
+{
+	return audio_buffer_view_of(a.channel_ptrs.data(), a.channels, a.frames);
+}
+
+// frames offset to offset + frames of every channel, for sub-block processing
+template <typename t_sample>
+audio_buffer_view<t_sample> audio_buffer_view_frames(const audio_buffer_view<t_sample>& v,
+													 size_t offset, size_t frames)
+{
+	if (offset > v.frames) offset = v.frames;
+	if (frames > v.frames - offset) frames = v.frames - offset;
+
+	audio_buffer_view<t_sample> sub = v;
+	sub.frames = frames;
+	for (size_t ch = 0; ch < v.channels; ++ch) sub.channel_ptrs[ch] += offset;
+	return sub;
+}
+
+// channels first to first + channels, e.g. one stereo pair of a multichannel buffer
+template <typename t_sample>
+audio_buffer_view<t_sample>
+audio_buffer_view_channels(const audio_buffer_view<t_sample>& v, size_t first,
+						   size_t channels)
+{
+	if (first > v.channels) first = v.channels;
+	if (channels > v.channels - first) channels = v.channels - first;
+
+	audio_buffer_view<t_sample> sub;
+	sub.channels = channels;
+	sub.frames = v.frames;
+	for (size_t ch = 0; ch < sub.channels; ++ch)
+		sub.channel_ptrs[ch] = v.channel_ptrs[first + ch];
+	return sub;
 }
 } // namespace trnr
@@ -24,6 +24,8 @@
 #pragma once
 
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 
 namespace trnr {
 
@@ -35,6 +37,57 @@ inline double lin_2_db(double lin)
 
 inline double db_2_lin(double db) { return pow(10.0, db / 20.0); }
 
+// fast base-2 logarithm for x > 0, max abs error ~1.8e-5 (~1.1e-4 dB)
+inline float fast_log2(float x)
+{
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	float exponent = (float)((int)((bits >> 23) & 0xff) - 127);
+	bits = (bits & 0x007fffff) | 0x3f800000; // mantissa in [1, 2)
+	float m;
+	memcpy(&m, &bits, sizeof(m));
+	m -= 1.f;
+
+	float p = 0.0439290999f;
+	p = p * m - 0.189834429f;
+	p = p * m + 0.411564149f;
+	p = p * m - 0.707254899f;
+	p = p * m + 1.44159239f;
+	p = p * m + 1.43724989e-05f;
+	return exponent + p;
+}
+
+// fast base-2 exponential, max relative error ~4.2e-6
+inline float fast_exp2(float x)
+{
+	if (x < -126.f) x = -126.f;
+	if (x > 127.f) x = 127.f;
+
+	float whole = floorf(x);
+	float f = x - whole;
+
+	float p = 0.0136839897f;
+	p = p * f + 0.051717781f;
+	p = p * f + 0.241621243f;
+	p = p * f + 0.692969586f;
+	p = p * f + 1.00000359f;
+
+	uint32_t bits = (uint32_t)((int)whole + 127) << 23;
+	float scale;
+	memcpy(&scale, &bits, sizeof(scale));
+	return p * scale;
+}
+
+inline float fast_exp(float x) { return fast_exp2(x * 1.44269504f); }
+
+inline float fast_lin_2_db(float lin)
+{
+	if (lin <= 1e-20f) lin = 1e-20f; // avoid log(0)
+	return 6.02059991f * fast_log2(lin);
+}
+
+inline float fast_db_2_lin(float db) { return fast_exp2(db * 0.166096404f); }
+
 inline float midi_to_frequency(float midi_note)
 {
 	return 440.0 * powf(2.0, ((float)midi_note - 69.0) / 12.0);
@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include "random.h"
 #include <math.h>
 
 namespace trnr {
@@ -34,12 +35,15 @@ struct demo_noise {
 	int noise_len_sec = 3;
 	int pause_len_sec = 17;
 	float noise_gain = 0.1f;
+
+	prng random;
 };
 
 inline void demo_noise_init(demo_noise& d, double samplerate)
 {
 	d.samplerate = samplerate;
 	d.counter = 0;
+	prng_init(d.random, prng_unique_seed());
 }
 
 // overwrites the input buffer with noise in the specified time frame
@@ -54,10 +58,7 @@ inline void demo_noise_process_block(demo_noise& d, float** samples, int blocksi
 
 		if (d.counter > total_len_samples) { d.counter = 0; }
 		if (d.counter > pause_len_samples) {
-			float r1 = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-			float r2 = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-
-			float noise = static_cast<float>(sqrt(-2.0 * log(r1)) * cos(2.0 * M_PI * r2));
+			float noise = prng_gaussian(d.random);
 
 			samples[0][s] = samples[1][s] = noise * d.noise_gain;
 		}
@@ -0,0 +1,125 @@
+/*
+ * denormal.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Define TRNR_ASSUME_FTZ when all processing runs inside a denormal_guard. Modules then
+// drop their per-sample denormal checks (tube, ysvf).
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define TRNR_DENORMAL_SSE
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP))
+#define TRNR_DENORMAL_ARM
+#endif
+
+namespace trnr {
+#if defined(TRNR_DENORMAL_SSE)
+// flush-to-zero (results) and denormals-are-zero (inputs) in MXCSR
+constexpr uint64_t DENORMAL_FLUSH_BITS = 0x8040;
+#elif defined(TRNR_DENORMAL_ARM)
+// FZ in FPCR (aarch64) or FPSCR (arm), covers inputs and results
+constexpr uint64_t DENORMAL_FLUSH_BITS = 1 << 24;
+#else
+constexpr uint64_t DENORMAL_FLUSH_BITS = 0;
+#endif
+
+// floating point control register of the calling thread, 0 where unsupported
+inline uint64_t denormal_get_state()
+{
+#if defined(TRNR_DENORMAL_SSE)
+	return _mm_getcsr();
+#elif defined(__aarch64__)
+	uint64_t fpcr;
+	__asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+	return fpcr;
+#elif defined(TRNR_DENORMAL_ARM)
+	uint32_t fpscr;
+	__asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+	return fpscr;
+#else
+	return 0;
+#endif
+}
+
+inline void denormal_set_state(uint64_t state)
+{
+#if defined(TRNR_DENORMAL_SSE)
+	_mm_setcsr((unsigned int)state);
+#elif defined(__aarch64__)
+	__asm__ __volatile__("msr fpcr, %0" : : "r"(state));
+#elif defined(TRNR_DENORMAL_ARM)
+	uint32_t fpscr = (uint32_t)state;
+	__asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+#else
+	(void)state;
+#endif
+}
+
+// turns flushing on for the calling thread and returns the state to restore
+inline uint64_t denormal_flush_begin()
+{
+	uint64_t saved = denormal_get_state();
+	if ((saved & DENORMAL_FLUSH_BITS) != DENORMAL_FLUSH_BITS)
+		denormal_set_state(saved | DENORMAL_FLUSH_BITS);
+	return saved;
+}
+
+inline void denormal_flush_end(uint64_t saved)
+{
+	if (denormal_get_state() != saved) denormal_set_state(saved);
+}
+
+// Flushes denormals to zero while in scope and restores the previous mode after, so the
+// host's own settings survive. Put one at the top of the audio callback:
+//
+//   void process(float** in, float** out, int frames)
+//   {
+//       trnr::denormal_guard guard;
+//       ...
+//   }
+//
+// The mode is per thread, a guard only covers the thread that created it.
+struct denormal_guard {
+	uint64_t saved;
+
+	denormal_guard()
+		: saved(denormal_flush_begin())
+	{
+	}
+
+	~denormal_guard() { denormal_flush_end(saved); }
+
+	denormal_guard(const denormal_guard&) = delete;
+	denormal_guard& operator=(const denormal_guard&) = delete;
+};
+
+// true if denormals are flushed on the calling thread right now
+inline bool denormal_flushing()
+{
+	return DENORMAL_FLUSH_BITS != 0 &&
+		   (denormal_get_state() & DENORMAL_FLUSH_BITS) == DENORMAL_FLUSH_BITS;
+}
+} // namespace trnr
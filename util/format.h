@@ -24,48 +24,128 @@
 #pragma once
 
 #include <algorithm>
+#include <cctype>
 #include <cstdarg>
-#include <iomanip>
-#include <sstream>
+#include <cstdio>
+#include <cstring>
 #include <string>
-#include <vector>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
 
 using namespace std;
 
 namespace trnr {
 
+///////////////////
+// FIXED BUFFERS //
+///////////////////
+
+// The functions below write into a caller-provided buffer, null-terminate it (if
+// size > 0) and return the length written. They never allocate, so parameter displays
+// can call them at any refresh rate.
+
+// Formats a string (like snprintf) into buf, truncated to size - 1 characters.
+inline size_t format_to(char* buf, size_t size, const char* fmt, ...)
+{
+	if (size == 0) return 0;
+
+	va_list args;
+	va_start(args, fmt);
+	int needed = vsnprintf(buf, size, fmt, args);
+	va_end(args);
+
+	if (needed < 0) {
+		buf[0] = '\0';
+		return 0;
+	}
+	return min(static_cast<size_t>(needed), size - 1);
+}
+
+// numbers that do not fit into size - 1 characters give an empty string
+inline size_t int_to_chars(char* buf, size_t size, int value)
+{
+	if (size == 0) return 0;
+
+#if defined(__cpp_lib_to_chars)
+	to_chars_result result = to_chars(buf, buf + size - 1, value);
+	size_t length = result.ec == errc() ? result.ptr - buf : 0;
+#else
+	int needed = snprintf(buf, size, "%d", value);
+	size_t length = needed < 0 || static_cast<size_t>(needed) >= size ? 0 : needed;
+#endif
+	buf[length] = '\0';
+	return length;
+}
+
+// value with precision decimals, trailing zeros and a trailing decimal point removed
+inline size_t float_to_chars_trimmed(char* buf, size_t size, float value,
+									 int precision = 2)
+{
+	if (size == 0) return 0;
+
+#if defined(__cpp_lib_to_chars)
+	to_chars_result result =
+		to_chars(buf, buf + size - 1, value, chars_format::fixed, precision);
+	size_t length = result.ec == errc() ? result.ptr - buf : 0;
+#else
+	int needed = snprintf(buf, size, "%.*f", precision, value);
+	size_t length = needed < 0 || static_cast<size_t>(needed) >= size ? 0 : needed;
+#endif
+
+	// without decimals the zeros are significant
+	if (length > 0 && memchr(buf, '.', length)) {
+		while (buf[length - 1] == '0') length--;
+		if (buf[length - 1] == '.') length--;
+	}
+	buf[length] = '\0';
+	return length;
+}
+
+// converts str in place, up to its null terminator
+inline void to_upper_chars(char* str)
+{
+	for (; *str; ++str)
+		if (*str >= 'a' && *str <= 'z') *str -= 'a' - 'A';
+}
+
+inline void to_lower_chars(char* str)
+{
+	for (; *str; ++str)
+		if (*str >= 'A' && *str <= 'Z') *str += 'a' - 'A';
+}
+
+/////////////
+// STRINGS //
+/////////////
+
 // Formats a string (like printf) using a format string and variable arguments.
 inline string format(const char* fmt, ...)
 {
 	va_list args;
 	va_start(args, fmt);
-	vector<char> buf(256);
-	int needed = vsnprintf(buf.data(), buf.size(), fmt, args);
+	char buf[256];
+	int needed = vsnprintf(buf, sizeof(buf), fmt, args);
 	va_end(args);
 
 	if (needed < 0) { return {}; }
-	if (static_cast<size_t>(needed) < buf.size()) { return string(buf.data(), needed); }
+	if (static_cast<size_t>(needed) < sizeof(buf)) { return string(buf, needed); }
 
-	// Resize and try again if the buffer was too small
-	buf.resize(needed + 1);
+	// Allocate and try again if the stack buffer was too small
+	string str(needed, '\0');
 	va_start(args, fmt);
-	vsnprintf(buf.data(), buf.size(), fmt, args);
+	vsnprintf(&str[0], needed + 1, fmt, args);
 	va_end(args);
 
-	return string(buf.data(), needed);
+	return str;
 }
 
 inline string float_to_string_trimmed(float value)
 {
-	ostringstream out;
-	out << fixed << setprecision(2) << value;
-	string str = out.str();
-
-	// Remove trailing zeros
-	str.erase(str.find_last_not_of('0') + 1, string::npos);
-	// If the last character is a decimal point, remove it as well
-	if (!str.empty() && str.back() == '.') { str.pop_back(); }
-	return str;
+	char buf[64];
+	size_t length = float_to_chars_trimmed(buf, sizeof(buf), value);
+	return string(buf, length);
 }
 
 inline string to_upper(string& str)
@@ -0,0 +1,88 @@
+/*
+ * param_queue.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "audio_buffer.h"
+
+namespace trnr {
+// events one block can hold, the host adds them before the block and the module's
+// *_process_block_events consumes them
+constexpr int PARAM_QUEUE_SIZE = 256;
+
+// sets param of the module to value from frame on, frame is relative to the block start
+struct param_event {
+	int frame;
+	int param;
+	float value;
+};
+
+struct param_queue {
+	param_event events[PARAM_QUEUE_SIZE];
+	int count = 0;
+};
+
+inline void param_queue_clear(param_queue& q) { q.count = 0; }
+
+// Keeps the events sorted by frame, events on the same frame stay in the order they were
+// added. Returns false and drops the event if the queue is full.
+inline bool param_queue_push(param_queue& q, int frame, int param, float value)
+{
+	if (q.count >= PARAM_QUEUE_SIZE) return false;
+
+	// hosts deliver in order, so this usually does not move anything
+	int i = q.count;
+	while (i > 0 && q.events[i - 1].frame > frame) {
+		q.events[i] = q.events[i - 1];
+		i--;
+	}
+	q.events[i] = {frame, param, value};
+	q.count++;
+	return true;
+}
+
+// Splits the block at the event frames. render(offset, frames) processes a sub-block
+// (see audio_buffer_view_frames), apply(param, value) changes a parameter in between.
+// Events before the block apply at its start, events beyond it at its end. Clears the
+// queue.
+template <typename t_render, typename t_apply>
+inline void param_queue_render(param_queue& q, int frames, t_render render, t_apply apply)
+{
+	int offset = 0;
+
+	for (int e = 0; e < q.count; e++) {
+		int frame = q.events[e].frame;
+		if (frame < offset) frame = offset;
+		if (frame > frames) frame = frames;
+
+		if (frame > offset) {
+			render(offset, frame - offset);
+			offset = frame;
+		}
+		apply(q.events[e].param, q.events[e].value);
+	}
+
+	if (offset < frames) render(offset, frames - offset);
+	q.count = 0;
+}
+} // namespace trnr
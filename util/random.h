@@ -0,0 +1,283 @@
+/*
+ * random.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRNR_RANDOM_SSE2
+#endif
+
+namespace trnr {
+// independent xorshift32 generators, the block functions advance all of them at once
+constexpr int PRNG_LANES = 4;
+
+// Per instance pseudo random numbers for the audio thread: no locks, no global state,
+// same sequence for the same seed. Not for cryptography.
+struct prng {
+	uint32_t state[PRNG_LANES];
+	int lane;
+};
+
+// a different seed on every call, so instances initialized with it do not correlate
+inline uint32_t prng_unique_seed()
+{
+	static std::atomic<uint32_t> counter {0};
+	return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void prng_init(prng& r, uint32_t seed)
+{
+	for (int i = 0; i < PRNG_LANES; i++) {
+		// splitmix32, spreads neighbouring seeds over the whole state
+		uint32_t z = seed + (uint32_t)(i + 1) * 0x9e3779b9u;
+		z = (z ^ (z >> 16)) * 0x85ebca6bu;
+		z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+		z ^= z >> 16;
+		// xorshift32 gets stuck at 0
+		r.state[i] = z ? z : 1;
+	}
+	r.lane = 0;
+}
+
+inline uint32_t prng_next(prng& r)
+{
+	uint32_t& x = r.state[r.lane];
+	r.lane = (r.lane + 1) & (PRNG_LANES - 1);
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+// 0 to 1, excluding 1
+inline float prng_uniform(prng& r) { return (prng_next(r) >> 8) * (1.f / 16777216.f); }
+
+// -1 to 1, excluding 1
+inline float prng_bipolar(prng& r)
+{
+	return (int32_t)(prng_next(r) & 0xffffff00u) * (1.f / 2147483648.f);
+}
+
+// 0 to n - 1
+inline uint32_t prng_below(prng& r, uint32_t n)
+{
+	return (uint32_t)(((uint64_t)prng_next(r) * n) >> 32);
+}
+
+// triangular distribution from -1 to 1, the sum of the two 16 bit halves of one number
+inline float prng_tpdf(prng& r)
+{
+	uint32_t x = prng_next(r);
+	return ((int16_t)x + (int16_t)(x >> 16)) * (1.f / 65536.f);
+}
+
+//////////////
+// GAUSSIAN //
+//////////////
+
+// Ziggurat tables of Marsaglia and Tsang for the standard normal distribution. 98.8% of
+// the numbers need one random number, a table lookup and a multiplication.
+struct prng_ziggurat {
+	std::array<uint32_t, 128> k;
+	std::array<float, 128> w;
+	std::array<float, 128> f;
+};
+
+inline prng_ziggurat prng_build_ziggurat()
+{
+	prng_ziggurat z;
+	const double m1 = 2147483648.0;
+	double dn = 3.442619855899;
+	double tn = dn;
+	const double vn = 9.91256303526217e-3;
+
+	double q = vn / exp(-0.5 * dn * dn);
+	z.k[0] = (uint32_t)((dn / q) * m1);
+	z.k[1] = 0;
+	z.w[0] = q / m1;
+	z.w[127] = dn / m1;
+	z.f[0] = 1.f;
+	z.f[127] = exp(-0.5 * dn * dn);
+
+	for (int i = 126; i >= 1; i--) {
+		dn = sqrt(-2.0 * log(vn / dn + exp(-0.5 * dn * dn)));
+		z.k[i + 1] = (uint32_t)((dn / tn) * m1);
+		tn = dn;
+		z.f[i] = exp(-0.5 * dn * dn);
+		z.w[i] = dn / m1;
+	}
+	return z;
+}
+
+// built on first use, read only after that
+inline const prng_ziggurat& prng_ziggurat_tables()
+{
+	static const prng_ziggurat tables = prng_build_ziggurat();
+	return tables;
+}
+
+// uniform without 0, for the logarithms of the slow path
+inline float prng_uniform_open(prng& r)
+{
+	return ((prng_next(r) >> 8) + 0.5f) * (1.f / 16777216.f);
+}
+
+// mean 0, standard deviation 1
+inline float prng_gaussian(prng& r, const prng_ziggurat& z)
+{
+	const float tail = 3.442620f;
+
+	for (;;) {
+		int32_t hz = (int32_t)prng_next(r);
+		int iz = hz & 127;
+		uint32_t magnitude = hz < 0 ? 0u - (uint32_t)hz : (uint32_t)hz;
+		float x = hz * z.w[iz];
+		if (magnitude < z.k[iz]) return x;
+
+		if (iz == 0) {
+			// beyond the base strip, sample the tail
+			float y;
+			do {
+				x = -logf(prng_uniform_open(r)) * (1.f / tail);
+				y = -logf(prng_uniform_open(r));
+			} while (y + y < x * x);
+			return hz > 0 ? tail + x : -tail - x;
+		}
+
+		// wedge between the strip and the curve
+		if (z.f[iz] + prng_uniform(r) * (z.f[iz - 1] - z.f[iz]) < expf(-0.5f * x * x))
+			return x;
+	}
+}
+
+inline float prng_gaussian(prng& r) { return prng_gaussian(r, prng_ziggurat_tables()); }
+
+// starting state for the airwindows style fpd dither of a module, at least 16386
+inline uint32_t prng_fpd_seed(prng& r)
+{
+	uint32_t fpd;
+	do fpd = prng_next(r);
+	while (fpd < 16386);
+	return fpd;
+}
+
+inline uint32_t prng_fpd_seed()
+{
+	prng r;
+	prng_init(r, prng_unique_seed());
+	return prng_fpd_seed(r);
+}
+
+////////////
+// BLOCKS //
+////////////
+
+#ifdef TRNR_RANDOM_SSE2
+// four steps of prng_next, one per lane
+inline __m128i prng_next_sse2(__m128i& state)
+{
+	state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+	state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+	state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+	return state;
+}
+
+inline __m128 prng_uniform_sse2(__m128i& state)
+{
+	__m128i bits = _mm_srli_epi32(prng_next_sse2(state), 8);
+	return _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.f / 16777216.f));
+}
+
+inline __m128 prng_bipolar_sse2(__m128i& state)
+{
+	__m128i bits = _mm_and_si128(prng_next_sse2(state), _mm_set1_epi32(0xffffff00));
+	return _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.f / 2147483648.f));
+}
+
+inline __m128 prng_tpdf_sse2(__m128i& state)
+{
+	__m128i x = prng_next_sse2(state);
+	__m128i low = _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+	__m128i high = _mm_srai_epi32(x, 16);
+	return _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(low, high)),
+					  _mm_set1_ps(1.f / 65536.f));
+}
+
+// Advances all lanes at once, returns the number of values written. The lanes only line
+// up with the scalar order from lane 0 on, so the block functions below produce the same
+// numbers as calling the scalar function n times.
+template <typename t_simd>
+inline int prng_block_sse2(prng& r, float* out, int n, t_simd simd)
+{
+	__m128i state = _mm_loadu_si128((const __m128i*)r.state);
+	int i = 0;
+	for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, simd(state));
+	_mm_storeu_si128((__m128i*)r.state, state);
+	return i;
+}
+#endif
+
+inline void prng_uniform_block(prng& r, float* out, int n)
+{
+	int i = 0;
+	for (; i < n && r.lane != 0; i++) out[i] = prng_uniform(r);
+#ifdef TRNR_RANDOM_SSE2
+	i += prng_block_sse2(r, out + i, n - i, prng_uniform_sse2);
+#endif
+	for (; i < n; i++) out[i] = prng_uniform(r);
+}
+
+inline void prng_bipolar_block(prng& r, float* out, int n)
+{
+	int i = 0;
+	for (; i < n && r.lane != 0; i++) out[i] = prng_bipolar(r);
+#ifdef TRNR_RANDOM_SSE2
+	i += prng_block_sse2(r, out + i, n - i, prng_bipolar_sse2);
+#endif
+	for (; i < n; i++) out[i] = prng_bipolar(r);
+}
+
+inline void prng_tpdf_block(prng& r, float* out, int n)
+{
+	int i = 0;
+	for (; i < n && r.lane != 0; i++) out[i] = prng_tpdf(r);
+#ifdef TRNR_RANDOM_SSE2
+	i += prng_block_sse2(r, out + i, n - i, prng_tpdf_sse2);
+#endif
+	for (; i < n; i++) out[i] = prng_tpdf(r);
+}
+
+// the rejections of the ziggurat do not vectorize, the tables are looked up once
+inline void prng_gaussian_block(prng& r, float* out, int n)
+{
+	const prng_ziggurat& z = prng_ziggurat_tables();
+	for (int i = 0; i < n; i++) out[i] = prng_gaussian(r, z);
+}
+} // namespace trnr
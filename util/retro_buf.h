@@ -25,6 +25,8 @@
 
 #include "../companding/alaw.h"
 #include "../filter/chebyshev.h"
+#include "random.h"
+#include "waveshaper.h"
 
 namespace trnr {
 
@@ -45,6 +47,15 @@ struct retro_buf_modulation {
 // options.
 class retro_buf {
 public:
+	retro_buf()
+	{
+		// the a-law curves never change, tabulate them once
+		waveshaper_build(m_alaw_encode, alaw_encode, -1.f, 1.f);
+		waveshaper_build(m_alaw_decode, alaw_decode, -1.f, 1.f);
+
+		prng_init(m_random, prng_unique_seed());
+	}
+
 	void set_host_samplerate(double _samplerate)
 	{
 		m_host_samplerate = _samplerate;
@@ -58,6 +69,10 @@ public:
 
 	void set_channel_count(size_t _channel_count) { m_channel_count = _channel_count; }
 
+	// the jitter is seeded differently in every instance, a fixed seed makes the output
+	// repeatable
+	void set_seed(uint32_t _seed) { prng_init(m_random, _seed); }
+
 	void start_playback()
 	{
 		if (m_modulation.reset || (!m_modulation.reset && m_playback_pos == -1)) {
@@ -141,6 +156,11 @@ private:
 	chebyshev m_imaging_filter_r;
 	retro_buf_modulation m_modulation;
 
+	waveshaper m_alaw_encode;
+	waveshaper m_alaw_decode;
+
+	prng m_random;
+
 	float midi_to_ratio(double midi_note)
 	{
 		return powf(powf(2, (float)midi_note - 60.f), 1.f / 12.f);
@@ -166,7 +186,7 @@ private:
 	int jitterize(int jitter)
 	{
 		if (jitter > 0) {
-			return static_cast<int>(rand() % jitter);
+			return static_cast<int>(prng_below(m_random, jitter));
 		} else {
 			return 0;
 		}
@@ -174,15 +194,15 @@ private:
 
 	void reduce_bitrate(double& value1, double& value2, double bit)
 	{
-		value1 = alaw_encode(value1);
-		value2 = alaw_encode(value2);
+		value1 = waveshaper_process_sample(m_alaw_encode, value1);
+		value2 = waveshaper_process_sample(m_alaw_encode, value2);
 
 		float resolution = powf(2, bit);
 		value1 = round(value1 * resolution) / resolution;
 		value2 = round(value2 * resolution) / resolution;
 
-		value1 = alaw_decode(value1);
-		value2 = alaw_decode(value2);
+		value1 = waveshaper_process_sample(m_alaw_decode, value1);
+		value2 = waveshaper_process_sample(m_alaw_decode, value2);
 	}
 };
 } // namespace trnr
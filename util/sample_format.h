@@ -0,0 +1,354 @@
+/*
+ * sample_format.h
+ * Copyright (c) 2025 Christopher Herb
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "audio_buffer.h"
+#include "random.h"
+#include <cmath>
+#include <stdint.h>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRNR_SAMPLE_FORMAT_SSE2
+#endif
+
+namespace trnr {
+// interleaved formats, integers are little endian, int24 is packed into 3 bytes
+enum sample_format {
+	SAMPLE_INT16,
+	SAMPLE_INT24,
+	SAMPLE_INT32,
+	SAMPLE_FLOAT32,
+	SAMPLE_FLOAT64,
+};
+
+inline size_t sample_format_bytes(sample_format format)
+{
+	switch (format) {
+	case SAMPLE_INT16: return 2;
+	case SAMPLE_INT24: return 3;
+	case SAMPLE_INT32: return 4;
+	case SAMPLE_FLOAT32: return 4;
+	default: return 8;
+	}
+}
+
+/////////////////
+// CONVERSIONS //
+/////////////////
+
+inline float sample_from_int16(int16_t value) { return value * (1.f / 32768.f); }
+
+inline float sample_from_int24(const uint8_t* bytes)
+{
+	uint32_t value = bytes[0] | (bytes[1] << 8) | ((uint32_t)bytes[2] << 16);
+	return ((int32_t)(value << 8) >> 8) * (1.f / 8388608.f);
+}
+
+inline double sample_from_int32(int32_t value) { return value * (1.0 / 2147483648.0); }
+
+// rounds to nearest, dither is in lsb
+inline int16_t sample_to_int16(float sample, float dither = 0.f)
+{
+	float scaled = sample * 32768.f + dither;
+	if (scaled > 32767.f) scaled = 32767.f;
+	if (scaled < -32768.f) scaled = -32768.f;
+	return (int16_t)std::lrint(scaled);
+}
+
+inline void sample_to_int24(float sample, uint8_t* bytes, float dither = 0.f)
+{
+	float scaled = sample * 8388608.f + dither;
+	if (scaled > 8388607.f) scaled = 8388607.f;
+	if (scaled < -8388608.f) scaled = -8388608.f;
+	int32_t value = (int32_t)std::lrint(scaled);
+	bytes[0] = (uint8_t)value;
+	bytes[1] = (uint8_t)(value >> 8);
+	bytes[2] = (uint8_t)(value >> 16);
+}
+
+inline int32_t sample_to_int32(double sample)
+{
+	double scaled = sample * 2147483648.0;
+	if (scaled > 2147483647.0) scaled = 2147483647.0;
+	if (scaled < -2147483648.0) scaled = -2147483648.0;
+	return (int32_t)std::llrint(scaled);
+}
+
+#ifdef TRNR_SAMPLE_FORMAT_SSE2
+// four samples scaled to int16 range, clamped and rounded to nearest
+inline __m128i sample_to_int16_sse2(__m128 samples, __m128 dither)
+{
+	__m128 scaled = _mm_add_ps(_mm_mul_ps(samples, _mm_set1_ps(32768.f)), dither);
+	scaled = _mm_min_ps(_mm_max_ps(scaled, _mm_set1_ps(-32768.f)), _mm_set1_ps(32767.f));
+	return _mm_cvtps_epi32(scaled);
+}
+
+// int16 lanes 0 to 3 sign extended and converted
+inline __m128 sample_from_int16_low_sse2(__m128i values)
+{
+	__m128i extended = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+	return _mm_mul_ps(_mm_cvtepi32_ps(extended), _mm_set1_ps(1.f / 32768.f));
+}
+
+inline __m128 sample_from_int16_high_sse2(__m128i values)
+{
+	__m128i extended = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+	return _mm_mul_ps(_mm_cvtepi32_ps(extended), _mm_set1_ps(1.f / 32768.f));
+}
+
+// The simd kernels cover mono and stereo, the most common host layouts. They return the
+// number of frames done, the scalar loops do the rest.
+
+inline size_t deinterleave_int16_sse2(const int16_t* in, float* const* planar,
+									  size_t channels, size_t frames)
+{
+	size_t i = 0;
+	if (channels == 1) {
+		for (; i + 8 <= frames; i += 8) {
+			__m128i values = _mm_loadu_si128((const __m128i*)(in + i));
+			_mm_storeu_ps(planar[0] + i, sample_from_int16_low_sse2(values));
+			_mm_storeu_ps(planar[0] + i + 4, sample_from_int16_high_sse2(values));
+		}
+	} else if (channels == 2) {
+		const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+		for (; i + 4 <= frames; i += 4) {
+			// l r l r, left is in the low 16 bits of each 32 bit lane
+			__m128i values = _mm_loadu_si128((const __m128i*)(in + 2 * i));
+			__m128i left = _mm_srai_epi32(_mm_slli_epi32(values, 16), 16);
+			__m128i right = _mm_srai_epi32(values, 16);
+			_mm_storeu_ps(planar[0] + i, _mm_mul_ps(_mm_cvtepi32_ps(left), scale));
+			_mm_storeu_ps(planar[1] + i, _mm_mul_ps(_mm_cvtepi32_ps(right), scale));
+		}
+	}
+	return i;
+}
+
+inline size_t deinterleave_float_sse2(const float* in, float* const* planar,
+									  size_t channels, size_t frames)
+{
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 4 <= frames; i += 4) {
+			__m128 a = _mm_loadu_ps(in + 2 * i);
+			__m128 b = _mm_loadu_ps(in + 2 * i + 4);
+			_mm_storeu_ps(planar[0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(planar[1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	}
+	return i;
+}
+
+inline size_t interleave_int16_sse2(const float* const* planar, int16_t* out,
+									size_t channels, size_t frames, prng* dither)
+{
+	if (channels > 2) return 0;
+
+	__m128i state = _mm_setzero_si128();
+	if (dither) state = _mm_loadu_si128((const __m128i*)dither->state);
+	auto next_dither = [&]() {
+		return dither ? prng_tpdf_sse2(state) : _mm_setzero_ps();
+	};
+
+	size_t i = 0;
+	if (channels == 1) {
+		for (; i + 4 <= frames; i += 4) {
+			__m128 mono = _mm_loadu_ps(planar[0] + i);
+			__m128i values = sample_to_int16_sse2(mono, next_dither());
+			_mm_storel_epi64((__m128i*)(out + i), _mm_packs_epi32(values, values));
+		}
+	} else {
+		for (; i + 4 <= frames; i += 4) {
+			__m128 left = _mm_loadu_ps(planar[0] + i);
+			__m128 right = _mm_loadu_ps(planar[1] + i);
+			// l r l r
+			__m128 first = _mm_unpacklo_ps(left, right);
+			__m128 second = _mm_unpackhi_ps(left, right);
+			__m128i low = sample_to_int16_sse2(first, next_dither());
+			__m128i high = sample_to_int16_sse2(second, next_dither());
+			_mm_storeu_si128((__m128i*)(out + 2 * i), _mm_packs_epi32(low, high));
+		}
+	}
+
+	if (dither) _mm_storeu_si128((__m128i*)dither->state, state);
+	return i;
+}
+
+inline size_t interleave_float_sse2(const float* const* planar, float* out,
+									size_t channels, size_t frames)
+{
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 4 <= frames; i += 4) {
+			__m128 left = _mm_loadu_ps(planar[0] + i);
+			__m128 right = _mm_loadu_ps(planar[1] + i);
+			_mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(left, right));
+			_mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(left, right));
+		}
+	}
+	return i;
+}
+#endif
+
+//////////////////
+// DEINTERLEAVE //
+//////////////////
+
+// interleaved frames of any format to planar channels
+template <typename t_sample>
+inline void deinterleave(const void* interleaved, sample_format format,
+						 t_sample* const* planar, size_t channels, size_t frames)
+{
+	constexpr bool simd = std::is_same<t_sample, float>::value;
+	size_t i = 0;
+
+	switch (format) {
+	case SAMPLE_INT16: {
+		const int16_t* in = (const int16_t*)interleaved;
+#ifdef TRNR_SAMPLE_FORMAT_SSE2
+		if constexpr (simd) i = deinterleave_int16_sse2(in, planar, channels, frames);
+#endif
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++)
+				planar[ch][i] = sample_from_int16(in[i * channels + ch]);
+		break;
+	}
+	case SAMPLE_INT24: {
+		const uint8_t* in = (const uint8_t*)interleaved;
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++)
+				planar[ch][i] = sample_from_int24(in + 3 * (i * channels + ch));
+		break;
+	}
+	case SAMPLE_INT32: {
+		const int32_t* in = (const int32_t*)interleaved;
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++)
+				planar[ch][i] = sample_from_int32(in[i * channels + ch]);
+		break;
+	}
+	case SAMPLE_FLOAT32: {
+		const float* in = (const float*)interleaved;
+#ifdef TRNR_SAMPLE_FORMAT_SSE2
+		if constexpr (simd) i = deinterleave_float_sse2(in, planar, channels, frames);
+#endif
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++)
+				planar[ch][i] = in[i * channels + ch];
+		break;
+	}
+	case SAMPLE_FLOAT64: {
+		const double* in = (const double*)interleaved;
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++)
+				planar[ch][i] = in[i * channels + ch];
+		break;
+	}
+	}
+}
+
+////////////////
+// INTERLEAVE //
+////////////////
+
+// Planar channels to interleaved frames of any format. Narrowing to int16 and int24 adds
+// +-1 lsb tpdf dither (see prng_tpdf) if a generator is passed, which decorrelates the
+// quantization error from the signal. Samples beyond -1 to 1 are clipped.
+template <typename t_sample>
+inline void interleave(t_sample* const* planar, void* interleaved, sample_format format,
+					   size_t channels, size_t frames, prng* dither = nullptr)
+{
+	constexpr bool simd = std::is_same<t_sample, float>::value;
+	size_t i = 0;
+
+	switch (format) {
+	case SAMPLE_INT16: {
+		int16_t* out = (int16_t*)interleaved;
+#ifdef TRNR_SAMPLE_FORMAT_SSE2
+		if constexpr (simd)
+			i = interleave_int16_sse2(planar, out, channels, frames, dither);
+#endif
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++) {
+				float d = dither ? prng_tpdf(*dither) : 0.f;
+				out[i * channels + ch] = sample_to_int16(planar[ch][i], d);
+			}
+		break;
+	}
+	case SAMPLE_INT24: {
+		uint8_t* out = (uint8_t*)interleaved;
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++) {
+				float d = dither ? prng_tpdf(*dither) : 0.f;
+				sample_to_int24(planar[ch][i], out + 3 * (i * channels + ch), d);
+			}
+		break;
+	}
+	case SAMPLE_INT32: {
+		int32_t* out = (int32_t*)interleaved;
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++)
+				out[i * channels + ch] = sample_to_int32(planar[ch][i]);
+		break;
+	}
+	case SAMPLE_FLOAT32: {
+		float* out = (float*)interleaved;
+#ifdef TRNR_SAMPLE_FORMAT_SSE2
+		if constexpr (simd) i = interleave_float_sse2(planar, out, channels, frames);
+#endif
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++)
+				out[i * channels + ch] = (float)planar[ch][i];
+		break;
+	}
+	case SAMPLE_FLOAT64: {
+		double* out = (double*)interleaved;
+		for (; i < frames; i++)
+			for (size_t ch = 0; ch < channels; ch++)
+				out[i * channels + ch] = planar[ch][i];
+		break;
+	}
+	}
+}
+
+//////////////////
+// AUDIO BUFFER //
+//////////////////
+
+template <typename t_sample>
+inline void audio_buffer_deinterleave(const audio_buffer_view<t_sample>& v,
+									  const void* interleaved, sample_format format)
+{
+	deinterleave(interleaved, format, v.channel_ptrs, v.channels, v.frames);
+}
+
+template <typename t_sample>
+inline void audio_buffer_interleave(const audio_buffer_view<t_sample>& v,
+									void* interleaved, sample_format format,
+									prng* dither = nullptr)
+{
+	interleave(v.channel_ptrs, interleaved, format, v.channels, v.frames, dither);
+}
+} // namespace trnr
@@ -81,4 +81,119 @@ inline float smoother_process_sample(smoother& s)
 	return s.current;
 }
 
+// Writes the next n values of a ramp with a single vectorizable loop and returns true
+// if the ramp has reached its target. Shared by smoother and smoother_bank.
+inline bool smoother_ramp(float& current, float target, float& increment,
+						  int32_t& remaining, float* out, int n)
+{
+	int ramp = remaining < n ? remaining : n;
+	const float start = current;
+	const float step = increment;
+
+	for (int i = 0; i < ramp; ++i) out[i] = start + step * (float)(i + 1);
+
+	remaining -= ramp;
+	if (remaining == 0) {
+		// ensure exact target at the end to avoid FP drift
+		current = target;
+		increment = 0.0f;
+		if (ramp > 0) out[ramp - 1] = target;
+	} else {
+		current = start + step * (float)ramp;
+	}
+
+	for (int i = ramp; i < n; ++i) out[i] = current;
+	return remaining == 0;
+}
+
+// Writes the next n smoothed values to out. Returns true if the smoother is settled, so
+// the caller can switch to a constant value for the following blocks.
+inline bool smoother_process_block(smoother& s, float* out, int n)
+{
+	return smoother_ramp(s.current, s.target, s.increment, s.remaining, out, n);
+}
+
+inline bool smoother_settled(const smoother& s) { return s.remaining == 0; }
+
+///////////////////
+// SMOOTHER BANK //
+///////////////////
+
+// many smoothers with the same time, state as one array per field so advancing all of
+// them vectorizes
+template <size_t size>
+struct smoother_bank {
+	float samplerate;
+	float time_samples;
+
+	float current[size];
+	float target[size];
+	float increment[size];
+	int32_t remaining[size];
+};
+
+template <size_t size>
+inline void smoother_bank_init(smoother_bank<size>& b, double samplerate, float time_ms,
+							   float initial_value = 0.0f)
+{
+	b.samplerate = fmax(0.0, samplerate);
+	b.time_samples = ms_to_samples(time_ms, b.samplerate);
+
+	for (size_t i = 0; i < size; ++i) {
+		b.current[i] = initial_value;
+		b.target[i] = initial_value;
+		b.increment[i] = 0.0f;
+		b.remaining[i] = 0;
+	}
+}
+
+template <size_t size>
+inline void smoother_bank_set_target(smoother_bank<size>& b, size_t index, float target)
+{
+	b.target[index] = target;
+
+	// immediate if time is zero or too short
+	if (b.time_samples <= 1.0f) {
+		b.current[index] = target;
+		b.increment[index] = 0.0f;
+		b.remaining[index] = 0;
+		return;
+	}
+
+	int32_t n = static_cast<int32_t>(fmax(1.0f, ceilf(b.time_samples)));
+	b.remaining[index] = n;
+	b.increment[index] = (target - b.current[index]) / static_cast<float>(n);
+}
+
+// Advances every smoother by n samples without writing the ramps, for parameters that
+// are read once per block. Returns true if all smoothers are settled.
+template <size_t size>
+inline bool smoother_bank_advance(smoother_bank<size>& b, int n)
+{
+	int32_t moving = 0;
+	for (size_t i = 0; i < size; ++i) {
+		int32_t steps = b.remaining[i] < n ? b.remaining[i] : n;
+		int32_t left = b.remaining[i] - steps;
+		float advanced = b.current[i] + b.increment[i] * (float)steps;
+
+		b.current[i] = left == 0 ? b.target[i] : advanced;
+		b.increment[i] = left == 0 ? 0.0f : b.increment[i];
+		b.remaining[i] = left;
+		moving |= left;
+	}
+	return moving == 0;
+}
+
+// Writes the next n values of every smoother to out[index]. Returns true if all
+// smoothers are settled.
+template <size_t size>
+inline bool smoother_bank_process_block(smoother_bank<size>& b, float** out, int n)
+{
+	bool settled = true;
+	for (size_t i = 0; i < size; ++i) {
+		settled &= smoother_ramp(b.current[i], b.target[i], b.increment[i],
+								 b.remaining[i], out[i], n);
+	}
+	return settled;
+}
 } // namespace trnr